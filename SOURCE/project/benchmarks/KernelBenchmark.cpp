@@ -0,0 +1,744 @@
+//Microbenchmarks of the intersection (scalar GeometryUtils and the block kernels the renderer uses), BRDF and Vector3/Matrix functions and of BVH refitting, without a scene, window or threads
+//Every workload is generated from a fixed seed, so runs of different builds test exactly the same rays and directions
+
+//Standard includes
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//Project includes
+#include "BRDFs.h"
+#include "CpuFeatures.h"
+#include "Kernels.h"
+#include "Utils.h"
+
+//The kernels of the level the benchmark is compiled for (KERNEL_BENCHMARK_ISA in CMakeLists.txt)
+#if defined(__AVX2__)
+#define KERNEL_NAMESPACE avx2
+#define KERNEL_ISA_LEVEL IsaLevel::AVX2
+#define KERNEL_TARGETS SIMD_TARGETS_AVX2
+#define KERNEL_FLOAT Float8
+#else
+#define KERNEL_NAMESPACE sse4
+#define KERNEL_ISA_LEVEL IsaLevel::SSE4
+#define KERNEL_TARGETS SIMD_TARGETS_SSE4
+#define KERNEL_FLOAT Float4
+#endif
+//Kernels.inl undefines the macros, the alias and the constant keep them
+namespace dae::KERNEL_NAMESPACE {}
+namespace kernels = dae::KERNEL_NAMESPACE;
+constexpr dae::IsaLevel BENCHMARK_ISA_LEVEL{ dae::KERNEL_ISA_LEVEL };
+#include "Kernels.inl"
+
+using namespace dae;
+
+namespace
+{
+	struct BenchmarkOptions final
+	{
+		uint32_t testCount{ 1 << 16 };
+		uint32_t repetitionCount{ 10 };
+		uint32_t seed{ 1234 };
+		//Only benchmarks whose name contains this run
+		std::string filter{};
+	};
+
+	//Where the rays of a workload go relative to the primitive
+	enum class Distribution
+	{
+		HitHeavy, //Aimed well inside the primitive
+		MissHeavy, //Aimed next to the primitive
+		Grazing //Tangent to the primitive or almost parallel to its surface
+	};
+	constexpr Distribution DISTRIBUTIONS[]{ Distribution::HitHeavy, Distribution::MissHeavy, Distribution::Grazing };
+
+	const char* GetDistributionName(Distribution distribution)
+	{
+		switch (distribution)
+		{
+		case Distribution::HitHeavy:
+			return "hit";
+		case Distribution::MissHeavy:
+			return "miss";
+		default:
+			return "grazing";
+		}
+	}
+
+#pragma region Workloads
+	float GetRandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return std::uniform_real_distribution<float>{ min, max }(rng);
+	}
+
+	Vector3 GetRandomUnitVector(std::mt19937& rng)
+	{
+		std::normal_distribution<float> distribution{};
+		while (true)
+		{
+			const Vector3 v{ distribution(rng), distribution(rng), distribution(rng) };
+			if (v.SqrMagnitude() > 1e-6f)
+				return v.Normalized();
+		}
+	}
+
+	//Random direction perpendicular to direction, scaled to a length in [minLength, maxLength]
+	Vector3 GetRandomPerpendicular(std::mt19937& rng, const Vector3& direction, float minLength, float maxLength)
+	{
+		while (true)
+		{
+			const Vector3 v{ GetRandomUnitVector(rng) };
+			const Vector3 perpendicular{ v - direction * Vector3::Dot(v, direction) };
+			if (perpendicular.SqrMagnitude() > 1e-6f)
+				return perpendicular.Normalized() * GetRandomFloat(rng, minLength, maxLength);
+		}
+	}
+
+	Ray GetRay(const Vector3& origin, const Vector3& target)
+	{
+		return Ray{ origin, (target - origin).Normalized() };
+	}
+
+	//Rays from all around towards a round primitive (sphere or sphere shaped mesh) with its center at the origin
+	//Hit rays pass the center closer than the radius, miss rays further away, grazing rays about at the radius
+	std::vector<Ray> CreateRoundWorkload(std::mt19937& rng, uint32_t count, Distribution distribution, float radius, float grazingWidth)
+	{
+		float minOffset{}, maxOffset{};
+		switch (distribution)
+		{
+		case Distribution::HitHeavy:
+			maxOffset = 0.8f * radius;
+			break;
+		case Distribution::MissHeavy:
+			minOffset = 1.2f * radius;
+			maxOffset = 3.f * radius;
+			break;
+		default:
+			minOffset = radius - grazingWidth;
+			maxOffset = radius + grazingWidth;
+			break;
+		}
+
+		std::vector<Ray> rays(count);
+		for (Ray& ray : rays)
+		{
+			const Vector3 origin{ GetRandomUnitVector(rng) * 10.f * radius };
+			const Vector3 toCenter{ (-origin).Normalized() };
+			ray = GetRay(origin, GetRandomPerpendicular(rng, toCenter, minOffset, maxOffset));
+		}
+		return rays;
+	}
+
+	//Rays from above the plane y = 0
+	//Hit rays go down, miss rays go up, grazing rays go down at less than about 1 degree
+	std::vector<Ray> CreatePlaneWorkload(std::mt19937& rng, uint32_t count, Distribution distribution)
+	{
+		std::vector<Ray> rays(count);
+		for (Ray& ray : rays)
+		{
+			const Vector3 origin{ GetRandomFloat(rng, -10.f, 10.f), GetRandomFloat(rng, 0.5f, 5.f), GetRandomFloat(rng, -10.f, 10.f) };
+			Vector3 direction{ GetRandomUnitVector(rng) };
+			switch (distribution)
+			{
+			case Distribution::HitHeavy:
+				direction.y = -std::max(std::abs(direction.y), 0.1f);
+				break;
+			case Distribution::MissHeavy:
+				direction.y = std::max(std::abs(direction.y), 0.1f);
+				break;
+			default:
+				direction.y = 0.f;
+				direction = direction.Normalized();
+				direction.y = -GetRandomFloat(rng, 0.001f, 0.02f);
+				break;
+			}
+			ray = Ray{ origin, direction.Normalized() };
+		}
+		return rays;
+	}
+
+	//Triangle in the plane z = 0 (see CreateTriangle)
+	//Hit rays aim inside it, miss rays next to it, grazing rays start almost in its plane and aim inside it
+	std::vector<Ray> CreateTriangleWorkload(std::mt19937& rng, uint32_t count, Distribution distribution, const Triangle& triangle)
+	{
+		const Vector3 centroid{ (triangle.v0 + triangle.v1 + triangle.v2) / 3.f };
+		const auto getPointInTriangle = [&](float shrink)
+		{
+			float u{ GetRandomFloat(rng, 0.f, 1.f) };
+			float v{ GetRandomFloat(rng, 0.f, 1.f) };
+			if (u + v > 1.f)
+			{
+				u = 1.f - u;
+				v = 1.f - v;
+			}
+			const Vector3 point{ triangle.v0 + (triangle.v1 - triangle.v0) * u + (triangle.v2 - triangle.v0) * v };
+			return centroid + (point - centroid) * shrink;
+		};
+
+		std::vector<Ray> rays(count);
+		for (Ray& ray : rays)
+		{
+			Vector3 origin{ GetRandomUnitVector(rng) * 5.f };
+			origin.z = origin.z < 0.f ? std::min(origin.z, -1.f) : std::max(origin.z, 1.f);
+
+			switch (distribution)
+			{
+			case Distribution::HitHeavy:
+				ray = GetRay(origin, getPointInTriangle(0.9f));
+				break;
+			case Distribution::MissHeavy:
+				//Outside of the triangle scaled up by 1.2 around its centroid, inside of it scaled up by 3
+				while (true)
+				{
+					const Vector3 target{ getPointInTriangle(3.f) };
+					const Vector3 shrunkTarget{ centroid + (target - centroid) / 1.2f };
+					if (!GeometryUtils::IsPointInTriangle(triangle, shrunkTarget))
+					{
+						ray = GetRay(origin, target);
+						break;
+					}
+				}
+				break;
+			default:
+			{
+				Vector3 inPlane{ GetRandomUnitVector(rng) };
+				inPlane.z = 0.f;
+				if (inPlane.SqrMagnitude() < 1e-6f)
+					inPlane = Vector3::UnitX;
+				origin = centroid + inPlane.Normalized() * 5.f;
+				origin.z = GetRandomFloat(rng, 0.01f, 0.1f) * (GetRandomFloat(rng, 0.f, 1.f) < 0.5f ? -1.f : 1.f);
+				ray = GetRay(origin, getPointInTriangle(0.9f));
+				break;
+			}
+			}
+		}
+		return rays;
+	}
+
+	Triangle CreateTriangle()
+	{
+		Triangle triangle{ { -1.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.5f, 0.f } };
+		triangle.cullMode = TriangleCullMode::NoCulling;
+		return triangle;
+	}
+
+	//Closed, bumpy sphere (radius 1 +- BUMP_HEIGHT) around the origin, about the triangle count of the low poly bunny
+	constexpr float BUMP_HEIGHT{ 0.05f };
+	TriangleMesh CreateMesh()
+	{
+		constexpr int stackCount{ 32 };
+		constexpr int sliceCount{ 64 };
+
+		std::vector<Vector3> positions{};
+		for (int stack{}; stack <= stackCount; ++stack)
+		{
+			const float theta{ PI * static_cast<float>(stack) / stackCount };
+			for (int slice{}; slice < sliceCount; ++slice)
+			{
+				const float phi{ PI_2 * static_cast<float>(slice) / sliceCount };
+				const float radius{ 1.f + BUMP_HEIGHT * std::sin(5.f * theta) * std::cos(7.f * phi) };
+				positions.emplace_back(radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi));
+			}
+		}
+
+		std::vector<int> indices{};
+		for (int stack{}; stack < stackCount; ++stack)
+		{
+			for (int slice{}; slice < sliceCount; ++slice)
+			{
+				const int i00{ stack * sliceCount + slice };
+				const int i01{ stack * sliceCount + (slice + 1) % sliceCount };
+				const int i10{ i00 + sliceCount };
+				const int i11{ i01 + sliceCount };
+				//The triangles at the poles are degenerate, they are skipped
+				if (stack != 0)
+					indices.insert(indices.end(), { i00, i01, i11 });
+				if (stack != stackCount - 1)
+					indices.insert(indices.end(), { i00, i11, i10 });
+			}
+		}
+		return TriangleMesh{ positions, indices, TriangleCullMode::BackFaceCulling };
+	}
+
+	//Shading directions around a normal, uniform over the hemisphere or all close to the horizon
+	struct ShadingWorkload final
+	{
+		std::vector<Vector3> normals{};
+		std::vector<Vector3> viewDirections{};
+		std::vector<Vector3> lightDirections{};
+		std::vector<Vector3> halfVectors{};
+
+		//Same directions in SoA form for the vectorized BRDFs
+		std::vector<float> normalX{}, normalY{}, normalZ{};
+		std::vector<float> viewX{}, viewY{}, viewZ{};
+		std::vector<float> lightX{}, lightY{}, lightZ{};
+		std::vector<float> halfX{}, halfY{}, halfZ{};
+	};
+
+	ShadingWorkload CreateShadingWorkload(std::mt19937& rng, uint32_t count, bool isGrazing)
+	{
+		const auto getDirectionAround = [&](const Vector3& normal)
+		{
+			const float cosAngle{ isGrazing ? GetRandomFloat(rng, 0.f, 0.05f) : GetRandomFloat(rng, 0.f, 1.f) };
+			const Vector3 tangent{ GetRandomPerpendicular(rng, normal, 1.f, 1.f) };
+			return (normal * cosAngle + tangent * std::sqrt(1.f - cosAngle * cosAngle)).Normalized();
+		};
+
+		ShadingWorkload workload{};
+		for (uint32_t index{}; index < count; ++index)
+		{
+			const Vector3 normal{ GetRandomUnitVector(rng) };
+			const Vector3 viewDirection{ getDirectionAround(normal) };
+			const Vector3 lightDirection{ getDirectionAround(normal) };
+			const Vector3 halfVector{ (viewDirection + lightDirection).Normalized() };
+
+			workload.normals.push_back(normal);
+			workload.viewDirections.push_back(viewDirection);
+			workload.lightDirections.push_back(lightDirection);
+			workload.halfVectors.push_back(halfVector);
+
+			workload.normalX.push_back(normal.x);
+			workload.normalY.push_back(normal.y);
+			workload.normalZ.push_back(normal.z);
+			workload.viewX.push_back(viewDirection.x);
+			workload.viewY.push_back(viewDirection.y);
+			workload.viewZ.push_back(viewDirection.z);
+			workload.lightX.push_back(lightDirection.x);
+			workload.lightY.push_back(lightDirection.y);
+			workload.lightZ.push_back(lightDirection.z);
+			workload.halfX.push_back(halfVector.x);
+			workload.halfY.push_back(halfVector.y);
+			workload.halfZ.push_back(halfVector.z);
+		}
+		return workload;
+	}
+#pragma endregion
+
+#pragma region Measuring
+	//Results are summed into here, so the compiler can't remove the tested functions
+	volatile float g_Sink{};
+
+	//Runs test(callIndex) for the whole workload, repetitionCount times, and prints the fastest repetition
+	//A test returns a float (1 for a hit, the BRDF value, ...) or a kernels::SIMD::FloatN for kernels::SIMD::WIDTH tests at once
+	//Results above 0 are counted as hits, all results are summed so the compiler can't remove the tested function
+	template<typename TestFunction>
+	void Measure(const BenchmarkOptions& options, const std::string& name, const char* distributionName, const TestFunction& test)
+	{
+		if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+			return;
+
+		using ResultType = decltype(test(0u));
+		constexpr uint32_t testsPerCall{ std::is_same_v<ResultType, kernels::SIMD::FloatN> ? kernels::SIMD::WIDTH : 1 };
+		//Vectorized tests only work on whole groups, the rest of the workload is left out
+		const uint32_t callCount{ options.testCount / testsPerCall };
+
+		double fastestTime{ DBL_MAX };
+		uint32_t hitCount{};
+		float checksum{};
+		for (uint32_t repetition{}; repetition < options.repetitionCount; ++repetition)
+		{
+			hitCount = 0;
+			checksum = 0.f;
+			const auto start{ std::chrono::steady_clock::now() };
+			for (uint32_t callIndex{}; callIndex < callCount; ++callIndex)
+			{
+				const ResultType result{ test(callIndex) };
+				if constexpr (testsPerCall == 1)
+				{
+					hitCount += result > 0.f ? 1 : 0;
+					checksum += result;
+				}
+				else
+				{
+					hitCount += std::popcount(static_cast<uint32_t>(kernels::SIMD::FloatN::MoveMask(result > kernels::SIMD::FloatN::Broadcast(0.f))));
+					float lanes[kernels::SIMD::WIDTH];
+					result.Store(lanes);
+					for (const float lane : lanes)
+						checksum += lane;
+				}
+			}
+			const std::chrono::duration<double> time{ std::chrono::steady_clock::now() - start };
+			fastestTime = std::min(fastestTime, time.count());
+		}
+		g_Sink = g_Sink + checksum;
+
+		const double testCount{ static_cast<double>(callCount) * testsPerCall };
+		std::cout << std::left << std::setw(40) << name << std::setw(10) << distributionName << std::right
+			<< std::fixed << std::setprecision(2)
+			<< std::setw(10) << fastestTime * 1e9 / testCount << " ns"
+			<< std::setw(10) << testCount / fastestTime / 1e6 << " M/s"
+			<< std::setw(9) << 100.0 * hitCount / testCount << " %\n"
+			<< std::defaultfloat;
+	}
+#pragma endregion
+
+	void RunGeometryBenchmarks(const BenchmarkOptions& options, std::mt19937& rng)
+	{
+		std::cout << "\n" << std::left << std::setw(40) << "Geometry test" << std::setw(10) << "rays" << std::right
+			<< std::setw(13) << "per test" << std::setw(14) << "throughput" << std::setw(11) << "hits" << "\n";
+
+		const Sphere sphere{ {}, 1.f };
+		const Plane plane{ {}, Vector3::UnitY };
+		const Triangle triangle{ CreateTriangle() };
+		const TriangleMesh mesh{ CreateMesh() };
+
+		//The block kernels test one ray against PRIMITIVE_BLOCK_WIDTH primitives, every lane holds the same primitive
+		//so the hit rates match the scalar tests and one block test costs as much as PRIMITIVE_BLOCK_WIDTH scalar tests
+		SphereBlock sphereBlock{};
+		PlaneBlock planeBlock{};
+		TriangleBlock triangleBlock{};
+		const TriangleRecord triangleRecord{ triangle.v0, triangle.v1 - triangle.v0, triangle.v2 - triangle.v0, triangle.normal };
+		for (uint32_t lane{}; lane < PRIMITIVE_BLOCK_WIDTH; ++lane)
+		{
+			sphereBlock.SetLane(lane, sphere, lane);
+			planeBlock.SetLane(lane, plane, lane);
+			triangleBlock.SetLane(lane, triangleRecord);
+		}
+		const float triangleCullSign{ kernels::GeometryUtils::GetCullSign(triangle.cullMode, false) };
+		const float triangleShadowCullSign{ kernels::GeometryUtils::GetCullSign(triangle.cullMode, true) };
+
+		for (const Distribution distribution : DISTRIBUTIONS)
+		{
+			const char* distributionName{ GetDistributionName(distribution) };
+
+			const std::vector<Ray> sphereRays{ CreateRoundWorkload(rng, options.testCount, distribution, 1.f, 0.02f) };
+			Measure(options, "HitTest_Sphere", distributionName, [&](uint32_t index)
+			{
+				HitRecord hitRecord{};
+				return GeometryUtils::HitTest_Sphere(sphere, sphereRays[index], hitRecord) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_Sphere (shadow)", distributionName, [&](uint32_t index)
+			{
+				return GeometryUtils::HitTest_Sphere(sphere, sphereRays[index]) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_SphereBlock", distributionName, [&](uint32_t index)
+			{
+				float closestT{ FLT_MAX };
+				uint32_t closestSphere{};
+				return kernels::GeometryUtils::HitTest_SphereBlock(sphereBlock, kernels::GeometryUtils::BlockRay{ sphereRays[index] }, closestT, closestSphere) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_SphereBlock (shadow)", distributionName, [&](uint32_t index)
+			{
+				return kernels::GeometryUtils::HitTest_SphereBlock(sphereBlock, kernels::GeometryUtils::BlockRay{ sphereRays[index] }) ? 1.f : 0.f;
+			});
+
+			const std::vector<Ray> planeRays{ CreatePlaneWorkload(rng, options.testCount, distribution) };
+			Measure(options, "HitTest_Plane", distributionName, [&](uint32_t index)
+			{
+				HitRecord hitRecord{};
+				return GeometryUtils::HitTest_Plane(plane, planeRays[index], hitRecord) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_Plane (shadow)", distributionName, [&](uint32_t index)
+			{
+				return GeometryUtils::HitTest_Plane(plane, planeRays[index]) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_PlaneBlock", distributionName, [&](uint32_t index)
+			{
+				float closestT{ FLT_MAX };
+				uint32_t closestPlane{};
+				return kernels::GeometryUtils::HitTest_PlaneBlock(planeBlock, kernels::GeometryUtils::BlockRay{ planeRays[index] }, closestT, closestPlane) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_PlaneBlock (shadow)", distributionName, [&](uint32_t index)
+			{
+				return kernels::GeometryUtils::HitTest_PlaneBlock(planeBlock, kernels::GeometryUtils::BlockRay{ planeRays[index] }) ? 1.f : 0.f;
+			});
+
+			const std::vector<Ray> triangleRays{ CreateTriangleWorkload(rng, options.testCount, distribution, triangle) };
+			Measure(options, "HitTest_Triangle", distributionName, [&](uint32_t index)
+			{
+				HitRecord hitRecord{};
+				return GeometryUtils::HitTest_Triangle(triangle, triangleRays[index], hitRecord) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_Triangle (shadow)", distributionName, [&](uint32_t index)
+			{
+				return GeometryUtils::HitTest_Triangle(triangle, triangleRays[index]) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_TriangleBlock", distributionName, [&](uint32_t index)
+			{
+				kernels::GeometryUtils::TriangleBlockHit closestHit{ FLT_MAX };
+				return kernels::GeometryUtils::HitTest_TriangleBlock(triangleBlock, kernels::GeometryUtils::BlockRay{ triangleRays[index], triangleCullSign }, closestHit) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_TriangleBlock (shadow)", distributionName, [&](uint32_t index)
+			{
+				return kernels::GeometryUtils::HitTest_TriangleBlock(triangleBlock, kernels::GeometryUtils::BlockRay{ triangleRays[index], triangleShadowCullSign }) ? 1.f : 0.f;
+			});
+
+			const std::vector<Ray> meshRays{ CreateRoundWorkload(rng, options.testCount, distribution, 1.f, BUMP_HEIGHT) };
+			Measure(options, "SlabTest_TriangleMesh", distributionName, [&](uint32_t index)
+			{
+				return kernels::GeometryUtils::SlabTest_TriangleMesh(mesh, meshRays[index]) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_TriangleMesh", distributionName, [&](uint32_t index)
+			{
+				HitRecord hitRecord{};
+				return kernels::GeometryUtils::HitTest_TriangleMesh(mesh, meshRays[index], hitRecord) ? 1.f : 0.f;
+			});
+			Measure(options, "HitTest_TriangleMesh (shadow)", distributionName, [&](uint32_t index)
+			{
+				return kernels::GeometryUtils::HitTest_TriangleMesh(mesh, meshRays[index]) ? 1.f : 0.f;
+			});
+		}
+	}
+
+	void RunBRDFBenchmarks(const BenchmarkOptions& options, std::mt19937& rng)
+	{
+		using kernels::SIMD::Vector3N;
+
+		std::cout << "\n" << std::left << std::setw(40) << "BRDF" << std::setw(10) << "samples" << std::right
+			<< std::setw(13) << "per sample" << std::setw(14) << "throughput" << std::setw(11) << "non zero" << "\n";
+
+		constexpr float kd{ 0.7f };
+		constexpr ColorRGB cd{ 0.9f, 0.5f, 0.2f };
+		constexpr float ks{ 0.5f };
+		constexpr float phongExponent{ 20.f };
+		constexpr ColorRGB f0{ 0.04f, 0.04f, 0.04f };
+		constexpr float roughness{ 0.4f };
+
+		for (const bool isGrazing : { false, true })
+		{
+			const ShadingWorkload workload{ CreateShadingWorkload(rng, options.testCount, isGrazing) };
+			const char* distributionName{ isGrazing ? "grazing" : "uniform" };
+			const auto& w{ workload };
+			const auto loadN = [&](uint32_t index) { return Vector3N::Load(&w.normalX[index], &w.normalY[index], &w.normalZ[index]); };
+			const auto loadV = [&](uint32_t index) { return Vector3N::Load(&w.viewX[index], &w.viewY[index], &w.viewZ[index]); };
+			const auto loadL = [&](uint32_t index) { return Vector3N::Load(&w.lightX[index], &w.lightY[index], &w.lightZ[index]); };
+			const auto loadH = [&](uint32_t index) { return Vector3N::Load(&w.halfX[index], &w.halfY[index], &w.halfZ[index]); };
+
+			Measure(options, "BRDF::Lambert", distributionName, [&](uint32_t index)
+			{
+				return kernels::BRDF::Lambert(kd * std::abs(w.normals[index].x), cd).r;
+			});
+			Measure(options, "BRDF::Phong", distributionName, [&](uint32_t index)
+			{
+				return kernels::BRDF::Phong(ks, phongExponent, w.lightDirections[index], w.viewDirections[index], w.normals[index]).r;
+			});
+			Measure(options, "BRDF::FresnelFunction_Schlick", distributionName, [&](uint32_t index)
+			{
+				return kernels::BRDF::FresnelFunction_Schlick(w.halfVectors[index], w.viewDirections[index], f0).r;
+			});
+			Measure(options, "BRDF::NormalDistribution_GGX", distributionName, [&](uint32_t index)
+			{
+				return kernels::BRDF::NormalDistribution_GGX(w.normals[index], w.halfVectors[index], roughness);
+			});
+			Measure(options, "BRDF::GeometryFunction_Smith", distributionName, [&](uint32_t index)
+			{
+				return kernels::BRDF::GeometryFunction_Smith(w.normals[index], w.viewDirections[index], w.lightDirections[index], roughness);
+			});
+
+			Measure(options, "BRDF::Phong (SIMD)", distributionName, [&](uint32_t index)
+			{
+				const uint32_t first{ index * kernels::SIMD::WIDTH };
+				return kernels::BRDF::Phong(ks, phongExponent, loadL(first), loadV(first), loadN(first)).r;
+			});
+			Measure(options, "BRDF::FresnelFunction_Schlick (SIMD)", distributionName, [&](uint32_t index)
+			{
+				const uint32_t first{ index * kernels::SIMD::WIDTH };
+				return kernels::BRDF::FresnelFunction_Schlick(loadH(first), loadV(first), f0).r;
+			});
+			Measure(options, "BRDF::NormalDistribution_GGX (SIMD)", distributionName, [&](uint32_t index)
+			{
+				const uint32_t first{ index * kernels::SIMD::WIDTH };
+				return kernels::BRDF::NormalDistribution_GGX(loadN(first), loadH(first), roughness);
+			});
+			Measure(options, "BRDF::GeometryFunction_Smith (SIMD)", distributionName, [&](uint32_t index)
+			{
+				const uint32_t first{ index * kernels::SIMD::WIDTH };
+				return kernels::BRDF::GeometryFunction_Smith(loadN(first), loadV(first), loadL(first), roughness);
+			});
+		}
+	}
+
+	//The Vector3 and Matrix operations everything else is built from, on random vectors and a random rotate/scale/translate transform
+	//The vector results are summed to one float, so no component can be optimized away
+	void RunMathBenchmarks(const BenchmarkOptions& options, std::mt19937& rng)
+	{
+		std::cout << "\n" << std::left << std::setw(40) << "Math" << std::setw(10) << "vectors" << std::right
+			<< std::setw(13) << "per call" << std::setw(14) << "throughput" << std::setw(11) << "above 0" << "\n";
+
+		std::vector<Vector3> a(options.testCount), b(options.testCount);
+		for (uint32_t index{}; index < options.testCount; ++index)
+		{
+			a[index] = GetRandomUnitVector(rng) * GetRandomFloat(rng, 0.1f, 10.f);
+			b[index] = GetRandomUnitVector(rng) * GetRandomFloat(rng, 0.1f, 10.f);
+		}
+		const Matrix transform{ Matrix::CreateScale(GetRandomFloat(rng, 0.5f, 2.f), GetRandomFloat(rng, 0.5f, 2.f), GetRandomFloat(rng, 0.5f, 2.f))
+			* Matrix::CreateRotation(GetRandomFloat(rng, 0.f, PI_2), GetRandomFloat(rng, 0.f, PI_2), GetRandomFloat(rng, 0.f, PI_2))
+			* Matrix::CreateTranslation(GetRandomUnitVector(rng) * 5.f) };
+		const auto sum = [](const Vector3& v) { return v.x + v.y + v.z; };
+
+		const char* distributionName{ "random" };
+		Measure(options, "Vector3::Dot", distributionName, [&](uint32_t index)
+		{
+			return Vector3::Dot(a[index], b[index]);
+		});
+		Measure(options, "Vector3::Cross", distributionName, [&](uint32_t index)
+		{
+			return sum(Vector3::Cross(a[index], b[index]));
+		});
+		Measure(options, "Vector3::Normalized", distributionName, [&](uint32_t index)
+		{
+			return sum(a[index].Normalized());
+		});
+		Measure(options, "Matrix::TransformPoint", distributionName, [&](uint32_t index)
+		{
+			return sum(transform.TransformPoint(a[index]));
+		});
+		Measure(options, "Matrix::TransformVector", distributionName, [&](uint32_t index)
+		{
+			return sum(transform.TransformVector(a[index]));
+		});
+		Measure(options, "Matrix::TransformPoint + Vector", distributionName, [&](uint32_t index)
+		{
+			return sum(transform.TransformPoint(a[index])) + sum(transform.TransformVector(b[index]));
+		});
+	}
+
+	//Deforms the mesh step by step (more twist around the y axis and a growing wave) and refits its BVH after every step
+	//Compares the refit tree with a fresh build of the same positions, Refit rebuilds once its cost passes the rebuild cost
+	void RunRefitBenchmark(const BenchmarkOptions& options)
+	{
+		if (!options.filter.empty() && std::string{ "BVH::Refit" }.find(options.filter) == std::string::npos)
+			return;
+
+		std::cout << "\n" << std::left << std::setw(16) << "BVH::Refit" << std::right
+			<< std::setw(12) << "refit SAH" << std::setw(12) << "build SAH" << std::setw(14) << "rebuild SAH" << std::setw(10) << "rebuilt"
+			<< std::setw(14) << "refit" << std::setw(14) << "build" << "\n";
+
+		const TriangleMesh mesh{ CreateMesh() };
+		const std::vector<Vector3>& restPositions{ mesh.pData->positions };
+		const std::vector<int>& indices{ mesh.pData->indices };
+
+		std::vector<Vector3> positions(restPositions.size());
+		std::vector<AABB> triangleBounds(indices.size() / 3);
+		const auto deform = [&](float amount)
+		{
+			for (size_t index{}; index < positions.size(); ++index)
+			{
+				const Vector3& p{ restPositions[index] };
+				const float twist{ amount * PI * p.y };
+				const float wave{ 1.f + 0.3f * amount * std::sin(4.f * p.y + 3.f * p.x) };
+				positions[index] = Vector3{ (p.x * std::cos(twist) - p.z * std::sin(twist)) * wave, p.y, (p.x * std::sin(twist) + p.z * std::cos(twist)) * wave };
+			}
+			for (size_t triangleIndex{}; triangleIndex < triangleBounds.size(); ++triangleIndex)
+			{
+				AABB& bounds{ triangleBounds[triangleIndex] };
+				bounds = AABB{};
+				for (size_t corner{}; corner < 3; ++corner)
+					bounds.Grow(positions[indices[triangleIndex * 3 + corner]]);
+			}
+		};
+
+		//Fastest of repetitionCount runs, in microseconds
+		const auto measure = [&](const auto& function)
+		{
+			double fastestTime{ DBL_MAX };
+			for (uint32_t repetition{}; repetition < options.repetitionCount; ++repetition)
+			{
+				const auto start{ std::chrono::steady_clock::now() };
+				function();
+				const std::chrono::duration<double> time{ std::chrono::steady_clock::now() - start };
+				fastestTime = std::min(fastestTime, time.count());
+			}
+			return fastestTime * 1e6;
+		};
+
+		deform(0.f);
+		BVH refitBVH{};
+		refitBVH.Build(triangleBounds, PRIMITIVE_BLOCK_WIDTH);
+
+		constexpr int stepCount{ 8 };
+		for (int step{ 1 }; step <= stepCount; ++step)
+		{
+			const float amount{ static_cast<float>(step) / stepCount };
+			deform(amount);
+
+			//Refit (or the rebuild it falls back to) is done once on the deformed positions, repeating it only refits the same bounds again
+			const float rebuildCost{ refitBVH.GetRebuildSAHCost() };
+			const bool isRebuilt{ refitBVH.Refit(triangleBounds) };
+			const float refitCost{ refitBVH.GetSAHCost() };
+			const double refitTime{ measure([&] { refitBVH.Refit(triangleBounds); }) };
+
+			BVH builtBVH{};
+			const double buildTime{ measure([&] { builtBVH.Build(triangleBounds, PRIMITIVE_BLOCK_WIDTH); }) };
+
+			std::cout << std::left << std::setw(16) << ("twist " + std::to_string(step) + "/" + std::to_string(stepCount)) << std::right
+				<< std::fixed << std::setprecision(2)
+				<< std::setw(12) << refitCost << std::setw(12) << builtBVH.GetSAHCost() << std::setw(14) << rebuildCost << std::setw(10) << (isRebuilt ? "yes" : "no")
+				<< std::setw(11) << refitTime << " us" << std::setw(11) << buildTime << " us\n"
+				<< std::defaultfloat;
+		}
+	}
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: GP1_KernelBenchmark [options]\n"
+			<< "  --count <tests>     rays or shading samples per workload (default 65536)\n"
+			<< "  --repetitions <n>   runs per benchmark, the fastest one is reported (default 10)\n"
+			<< "  --seed <seed>       seed of the workloads (default 1234)\n"
+			<< "  --filter <text>     only run the benchmarks with <text> in their name\n";
+	}
+
+	bool ParseCommandLine(int argc, char* args[], BenchmarkOptions& options)
+	{
+		for (int i{ 1 }; i < argc; ++i)
+		{
+			const std::string argument{ args[i] };
+			if (argument == "--help" || i + 1 >= argc)
+				return false;
+
+			const char* value{ args[++i] };
+			if (argument == "--count")
+				options.testCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+			else if (argument == "--repetitions")
+				options.repetitionCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+			else if (argument == "--seed")
+				options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+			else if (argument == "--filter")
+				options.filter = value;
+			else
+				return false;
+		}
+		return options.testCount >= kernels::SIMD::WIDTH && options.repetitionCount > 0;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	BenchmarkOptions options{};
+	if (!ParseCommandLine(argc, args, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (!IsCpuSupported())
+	{
+		std::cout << "This cpu is not supported, the kernels need at least SSE4.2 and POPCNT\n";
+		return 1;
+	}
+	if (BENCHMARK_ISA_LEVEL > GetSupportedIsaLevel())
+	{
+		std::cout << "Built for " << GetIsaLevelName(BENCHMARK_ISA_LEVEL) << ", this cpu supports up to " << GetIsaLevelName(GetSupportedIsaLevel()) << "\n";
+		return 1;
+	}
+
+	std::cout << "Kernel benchmark [" << GetIsaLevelName(BENCHMARK_ISA_LEVEL) << ", SIMD width " << kernels::SIMD::WIDTH << "]: "
+		<< options.testCount << " tests per workload, fastest of " << options.repetitionCount << " runs, seed " << options.seed << "\n";
+
+	//One generator for everything, the workloads only depend on the seed and the count
+	std::mt19937 rng{ options.seed };
+	RunGeometryBenchmarks(options, rng);
+	RunBRDFBenchmarks(options, rng);
+	RunMathBenchmarks(options, rng);
+	RunRefitBenchmark(options);
+	return 0;
+}
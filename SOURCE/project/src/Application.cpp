@@ -0,0 +1,510 @@
+//External includes
+#include "SDL.h"
+#include "SDL_surface.h"
+
+//Standard includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+//Project includes
+#include "Application.h"
+#include "CameraPath.h"
+#include "CpuFeatures.h"
+#include "RayStatistics.h"
+#include "Timer.h"
+#include "Renderer.h"
+#include "RenderScaleController.h"
+#include "Scene.h"
+
+namespace dae
+{
+	namespace
+	{
+		std::unique_ptr<Scene> CreateScene(const CommandLineOptions& options)
+		{
+			std::unique_ptr<Scene> pScene{};
+			const std::string& sceneName{ options.sceneName };
+			if (sceneName == "reference")
+				pScene = std::make_unique<Scene_Reference>();
+			else if (sceneName == "bunny")
+				pScene = std::make_unique<Scene_Bunny>();
+			else if (sceneName == "bunnygrid")
+				pScene = std::make_unique<Scene_BunnyGrid>();
+			else if (sceneName == "spherefield")
+				pScene = std::make_unique<Scene_SphereField>();
+			else
+				return nullptr;
+
+			pScene->Initialize();
+			if (!options.animation)
+				pScene->ToggleAnimation();
+			return pScene;
+		}
+
+		void ConfigureRenderer(Renderer& renderer, const CommandLineOptions& options, IsaLevel isaLevel)
+		{
+			renderer.SetIsaLevel(isaLevel);
+			if (options.threadCount != 0)
+				renderer.SetThreadCount(options.threadCount);
+			if (options.tileSize != 0)
+				renderer.SetTileSize(options.tileSize);
+			if (options.deferredShading)
+				renderer.ToggleDeferredShading();
+			if (options.sRGB)
+				renderer.ToggleSRGB();
+			if (options.progressive)
+				renderer.ToggleProgressiveRendering();
+			if (options.antiAliasingRayBudget != 0)
+				renderer.SetAntiAliasingRayBudget(options.antiAliasingRayBudget);
+			if (options.adaptiveAA)
+				renderer.ToggleAdaptiveAntiAliasing();
+		}
+
+		void PrintFramebufferError(const CommandLineOptions& options)
+		{
+			std::cout << "Could not create a " << options.width << "x" << options.height << " framebuffer: " << SDL_GetError() << "\n";
+		}
+
+		//Appended to the frame time prints while dynamic resolution is enabled: the scale and the frame times the controller picked it from
+		void PrintRenderScale(const Renderer& renderer, const RenderScaleController& controller)
+		{
+			const std::streamsize precision{ std::cout.precision() };
+			std::cout << ", scale " << renderer.GetRenderScale() << " (" << renderer.GetRenderWidth() << "x" << renderer.GetRenderHeight() << ")"
+				<< ", avg " << std::fixed << std::setprecision(1) << controller.GetAverageFrameTime() * 1000.f << " ms [";
+			for (uint32_t index{}; index < controller.GetFrameTimeCount(); ++index)
+			{
+				std::cout << (index == 0 ? "" : " ") << controller.GetFrameTime(index) * 1000.f;
+			}
+			std::cout << "]" << std::defaultfloat << std::setprecision(precision);
+		}
+
+		//Only called in builds with RAY_STATISTICS, time is the render (or wall clock) time the statistics were counted in
+		void PrintRayStatistics(const RayStatistics& statistics, float time)
+		{
+			const double raysPerSecond{ time > 0.f ? static_cast<double>(statistics.GetRayCount()) / time : 0.0 };
+			const std::streamsize precision{ std::cout.precision() };
+			std::cout << "[RAY STATISTICS]:\t" << std::fixed << std::setprecision(2) << raysPerSecond / 1e6 << " Mrays/s, "
+				<< statistics.GetTestsPerRay() << " tests/ray (" << statistics.primaryRays << " primary, "
+				<< statistics.shadowRaysCast << " shadow, " << statistics.shadowRaysCulled << " shadow culled, "
+				<< statistics.primitiveTests << " primitive tests, " << statistics.slabTests << " slab tests)\n"
+				<< std::defaultfloat << std::setprecision(precision);
+		}
+
+		//Plays one frame of a benchmark: the camera pose of the path at the time of the timer, then a fixed step
+		//Returns the render time in seconds
+		float PlayBenchmarkFrame(Renderer& renderer, Scene& scene, const CameraPath& cameraPath, Timer& timer, float timeStep)
+		{
+			const CameraKeyframe pose{ cameraPath.Sample(timer.GetTotal()) };
+			scene.SetCameraPose(pose.origin, pose.pitch, pose.yaw);
+			scene.Update(&timer);
+
+			const uint64_t renderStart{ SDL_GetPerformanceCounter() };
+			renderer.Render(&scene);
+			const float renderTime{ static_cast<float>(SDL_GetPerformanceCounter() - renderStart) / static_cast<float>(SDL_GetPerformanceFrequency()) };
+
+			timer.Step(timeStep);
+			return renderTime;
+		}
+
+		//Nearest rank percentile of sorted values, percentile in [0, 100]
+		float GetPercentile(const std::vector<float>& sortedValues, float percentile)
+		{
+			if (sortedValues.empty())
+				return 0.f;
+			const size_t rank{ static_cast<size_t>(std::ceil(percentile / 100.f * static_cast<float>(sortedValues.size()))) };
+			return sortedValues[std::clamp<size_t>(rank, 1, sortedValues.size()) - 1];
+		}
+
+		//JSON string with the quotes and backslashes (Windows paths) escaped
+		void WriteJsonString(std::ostream& stream, const std::string& value)
+		{
+			stream << '"';
+			for (const char character : value)
+			{
+				if (character == '"' || character == '\\')
+					stream << '\\';
+				stream << character;
+			}
+			stream << '"';
+		}
+	}
+
+	int RunHeadless(const CommandLineOptions& options, IsaLevel isaLevel)
+	{
+		//No video subsystem, the renderer owns its framebuffer
+		const auto pTimer = std::make_unique<Timer>();
+		Renderer renderer{ options.width, options.height };
+		if (!renderer.IsValid())
+		{
+			PrintFramebufferError(options);
+			return 1;
+		}
+		ConfigureRenderer(renderer, options, isaLevel);
+
+		const std::unique_ptr<Scene> pScene{ CreateScene(options) };
+		if (!pScene)
+		{
+			std::cout << "Unknown scene: " << options.sceneName << "\n";
+			return 1;
+		}
+
+		const uint32_t frameCount{ options.frameCount != 0 ? options.frameCount : 1 };
+		const char* extension{ options.rawOutput ? "raw" : "bmp" };
+		std::string filePath(options.outputPath.size() + 16, '\0');
+		float totalRenderTime{};
+		//Headless frames are judged by their render time, saving them is not part of the frame
+		RenderScaleController scaleController{ options.targetFrameTime / 1000.f, options.minScale, options.maxScale };
+		if (options.dynamicResolution)
+			renderer.SetRenderScale(scaleController.GetScale());
+
+		pTimer->Start();
+		for (uint32_t frameIndex{}; frameIndex < frameCount; ++frameIndex)
+		{
+			//--------- Update ---------
+			pScene->Update(pTimer.get());
+
+			//--------- Render ---------
+			const uint64_t renderStart{ SDL_GetPerformanceCounter() };
+			renderer.Render(pScene.get());
+			const float renderTime{ static_cast<float>(SDL_GetPerformanceCounter() - renderStart) / static_cast<float>(SDL_GetPerformanceFrequency()) };
+			totalRenderTime += renderTime;
+
+			//--------- Output ---------
+			filePath.resize(options.outputPath.size() + 16);
+			const int length{ std::snprintf(filePath.data(), filePath.size(), "%s_%04u.%s", options.outputPath.c_str(), frameIndex, extension) };
+			filePath.resize(static_cast<size_t>(length));
+
+			const bool failed{ options.rawOutput ? renderer.SaveBufferToRaw(filePath.c_str()) : renderer.SaveBufferToImage(filePath.c_str()) };
+			if (failed)
+			{
+				std::cout << "Could not write " << filePath << "\n";
+				return 1;
+			}
+			std::cout << "Frame " << frameIndex << ": " << renderTime * 1000.f << " ms -> " << filePath;
+			if (options.dynamicResolution)
+				PrintRenderScale(renderer, scaleController);
+			std::cout << "\n";
+			if constexpr (RAY_STATISTICS_ENABLED)
+				PrintRayStatistics(renderer.GetRayStatistics(), renderTime);
+
+			if (options.dynamicResolution)
+			{
+				scaleController.Update(renderTime);
+				renderer.SetRenderScale(scaleController.GetScale());
+			}
+
+			//--------- Timer ---------
+			pTimer->Update();
+		}
+		pTimer->Stop();
+
+		std::cout << "Average render time: " << totalRenderTime * 1000.f / static_cast<float>(frameCount) << " ms [" << GetIsaLevelName(renderer.GetIsaLevel()) << "]\n";
+		return 0;
+	}
+
+	int RunBenchmark(const CommandLineOptions& options, IsaLevel isaLevel)
+	{
+		Renderer renderer{ options.width, options.height };
+		if (!renderer.IsValid())
+		{
+			PrintFramebufferError(options);
+			return 1;
+		}
+		ConfigureRenderer(renderer, options, isaLevel);
+
+		const std::unique_ptr<Scene> pScene{ CreateScene(options) };
+		if (!pScene)
+		{
+			std::cout << "Unknown scene: " << options.sceneName << "\n";
+			return 1;
+		}
+
+		CameraPath cameraPath{};
+		if (options.cameraPathFile.empty())
+			cameraPath.CreateFlyThrough(pScene->GetCamera());
+		else if (!cameraPath.LoadFromFile(options.cameraPathFile))
+		{
+			std::cout << "Could not read camera path " << options.cameraPathFile << "\n";
+			return 1;
+		}
+
+		//Scene animation and camera follow the fixed time step, every run renders the same frames
+		const float timeStep{ options.timeStep / 1000.f };
+		const uint32_t frameCount{ options.frameCount != 0 ? options.frameCount : static_cast<uint32_t>(cameraPath.GetDuration() / timeStep) + 1 };
+
+		//Warm up (thread pool, caches, lazily allocated buffers) on the start of the path, these frames are not measured
+		{
+			Timer warmupTimer{};
+			for (uint32_t frameIndex{}; frameIndex < options.warmupFrameCount; ++frameIndex)
+			{
+				PlayBenchmarkFrame(renderer, *pScene, cameraPath, warmupTimer, timeStep);
+			}
+		}
+
+		std::cout << "Benchmark: " << options.sceneName << ", " << frameCount << " frames at " << renderer.GetRenderWidth() << "x" << renderer.GetRenderHeight()
+			<< ", " << renderer.GetThreadCount() << " threads [" << GetIsaLevelName(renderer.GetIsaLevel()) << "]\n";
+
+		Timer timer{};
+		std::vector<float> renderTimes(frameCount);
+		std::vector<uint64_t> primaryRayCounts(frameCount);
+		std::vector<RayStatistics> frameStatistics(frameCount);
+		float totalRenderTime{};
+		uint64_t totalPrimaryRayCount{};
+		RayStatistics totalStatistics{};
+		for (uint32_t frameIndex{}; frameIndex < frameCount; ++frameIndex)
+		{
+			renderTimes[frameIndex] = PlayBenchmarkFrame(renderer, *pScene, cameraPath, timer, timeStep);
+			primaryRayCounts[frameIndex] = renderer.GetPrimaryRayCount();
+			frameStatistics[frameIndex] = renderer.GetRayStatistics();
+			totalRenderTime += renderTimes[frameIndex];
+			totalPrimaryRayCount += primaryRayCounts[frameIndex];
+			totalStatistics += frameStatistics[frameIndex];
+		}
+
+		std::vector<float> sortedRenderTimes{ renderTimes };
+		std::sort(sortedRenderTimes.begin(), sortedRenderTimes.end());
+		const float averageRenderTime{ totalRenderTime / static_cast<float>(frameCount) };
+		const float p50{ GetPercentile(sortedRenderTimes, 50.f) };
+		const float p95{ GetPercentile(sortedRenderTimes, 95.f) };
+		const float p99{ GetPercentile(sortedRenderTimes, 99.f) };
+		const double raysPerSecond{ totalRenderTime > 0.f ? static_cast<double>(totalPrimaryRayCount) / totalRenderTime : 0.0 };
+
+		//Times in milliseconds, rays are camera rays (Renderer::GetPrimaryRayCount)
+		//Builds with RAY_STATISTICS add the traversal counters, their rays include the shadow rays
+		std::ofstream report{ options.benchmarkPath };
+		report << "{\n";
+		report << "\t\"scene\": ";
+		WriteJsonString(report, options.sceneName);
+		report << ",\n\t\"cameraPath\": ";
+		WriteJsonString(report, options.cameraPathFile.empty() ? "flythrough" : options.cameraPathFile);
+		report << ",\n\t\"isa\": \"" << GetIsaLevelName(renderer.GetIsaLevel()) << "\",\n"
+			<< "\t\"threads\": " << renderer.GetThreadCount() << ",\n"
+			<< "\t\"tileSize\": " << renderer.GetTileSize() << ",\n"
+			<< "\t\"width\": " << renderer.GetRenderWidth() << ",\n"
+			<< "\t\"height\": " << renderer.GetRenderHeight() << ",\n"
+			<< "\t\"deferredShading\": " << (options.deferredShading ? "true" : "false") << ",\n"
+			<< "\t\"sRGB\": " << (options.sRGB ? "true" : "false") << ",\n"
+			<< "\t\"progressive\": " << (options.progressive ? "true" : "false") << ",\n"
+			<< "\t\"adaptiveAA\": " << (options.adaptiveAA ? "true" : "false") << ",\n"
+			<< "\t\"animation\": " << (options.animation ? "true" : "false") << ",\n"
+			<< "\t\"timeStep\": " << options.timeStep << ",\n"
+			<< "\t\"warmupFrames\": " << options.warmupFrameCount << ",\n"
+			<< "\t\"frameCount\": " << frameCount << ",\n"
+			<< "\t\"totalTime\": " << totalRenderTime * 1000.f << ",\n"
+			<< "\t\"averageTime\": " << averageRenderTime * 1000.f << ",\n"
+			<< "\t\"minTime\": " << sortedRenderTimes.front() * 1000.f << ",\n"
+			<< "\t\"maxTime\": " << sortedRenderTimes.back() * 1000.f << ",\n"
+			<< "\t\"p50\": " << p50 * 1000.f << ",\n"
+			<< "\t\"p95\": " << p95 * 1000.f << ",\n"
+			<< "\t\"p99\": " << p99 * 1000.f << ",\n"
+			<< "\t\"primaryRays\": " << totalPrimaryRayCount << ",\n"
+			<< "\t\"raysPerSecond\": " << std::fixed << std::setprecision(0) << raysPerSecond << std::defaultfloat << std::setprecision(6) << ",\n";
+		if constexpr (RAY_STATISTICS_ENABLED)
+		{
+			const double allRaysPerSecond{ totalRenderTime > 0.f ? static_cast<double>(totalStatistics.GetRayCount()) / totalRenderTime : 0.0 };
+			report << "\t\"rayStatistics\": {\n"
+				<< "\t\t\"shadowRaysCast\": " << totalStatistics.shadowRaysCast << ",\n"
+				<< "\t\t\"shadowRaysCulled\": " << totalStatistics.shadowRaysCulled << ",\n"
+				<< "\t\t\"primitiveTests\": " << totalStatistics.primitiveTests << ",\n"
+				<< "\t\t\"slabTests\": " << totalStatistics.slabTests << ",\n"
+				<< "\t\t\"raysPerSecond\": " << std::fixed << std::setprecision(0) << allRaysPerSecond << std::defaultfloat << std::setprecision(6) << ",\n"
+				<< "\t\t\"testsPerRay\": " << totalStatistics.GetTestsPerRay() << "\n"
+				<< "\t},\n";
+		}
+		report << "\t\"frames\": [\n";
+		for (uint32_t frameIndex{}; frameIndex < frameCount; ++frameIndex)
+		{
+			report << "\t\t{ \"renderTime\": " << renderTimes[frameIndex] * 1000.f << ", \"primaryRays\": " << primaryRayCounts[frameIndex];
+			if constexpr (RAY_STATISTICS_ENABLED)
+				report << ", \"shadowRays\": " << frameStatistics[frameIndex].shadowRaysCast << ", \"testsPerRay\": " << frameStatistics[frameIndex].GetTestsPerRay();
+			report << " }" << (frameIndex + 1 < frameCount ? ",\n" : "\n");
+		}
+		report << "\t]\n}\n";
+		report.close();
+		if (!report)
+		{
+			std::cout << "Could not write " << options.benchmarkPath << "\n";
+			return 1;
+		}
+
+		std::cout << "Render time avg " << averageRenderTime * 1000.f << " ms, p50 " << p50 * 1000.f << " ms, p95 " << p95 * 1000.f
+			<< " ms, p99 " << p99 * 1000.f << " ms, " << raysPerSecond / 1e6 << " Mrays/s -> " << options.benchmarkPath << "\n";
+		if constexpr (RAY_STATISTICS_ENABLED)
+			PrintRayStatistics(totalStatistics, totalRenderTime);
+		return 0;
+	}
+
+	int RunWindowed(const CommandLineOptions& options, IsaLevel isaLevel)
+	{
+		//Create window + surfaces
+		SDL_Init(SDL_INIT_VIDEO);
+
+		SDL_Window* pWindow = SDL_CreateWindow(
+			"RayTracer - Senne Goeminne (2DAE19)",
+			SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED,
+			static_cast<int>(options.width), static_cast<int>(options.height), 0);
+
+		if (!pWindow)
+			return 1;
+
+		//Initialize "framework"
+		const auto pTimer = new Timer();
+		const auto pRenderer = new Renderer(pWindow);
+		if (!pRenderer->IsValid())
+		{
+			PrintFramebufferError(options);
+			delete pRenderer;
+			delete pTimer;
+			SDL_DestroyWindow(pWindow);
+			return 1;
+		}
+		ConfigureRenderer(*pRenderer, options, isaLevel);
+		RenderScaleController scaleController{ options.targetFrameTime / 1000.f, options.minScale, options.maxScale };
+		bool isDynamicResolutionEnabled{ options.dynamicResolution };
+		if (isDynamicResolutionEnabled)
+			pRenderer->SetRenderScale(scaleController.GetScale());
+
+		const std::unique_ptr<Scene> pScene{ CreateScene(options) };
+		if (!pScene)
+		{
+			std::cout << "Unknown scene: " << options.sceneName << "\n";
+			delete pRenderer;
+			delete pTimer;
+			SDL_DestroyWindow(pWindow);
+			return 1;
+		}
+
+		//Every frame becomes a keyframe, the path can be played back with --benchmark --camera-path
+		const bool isRecordingCameraPath{ !options.recordCameraPathFile.empty() };
+		CameraPath recordedCameraPath{};
+
+		//Start loop
+		pTimer->Start();
+
+		// Start Benchmark
+		// pTimer->StartBenchmark();
+
+		float printTimer = 0.f;
+		//Rays of the frames since the last print, only counted with RAY_STATISTICS
+		RayStatistics printStatistics{};
+		bool isLooping = true;
+		bool takeScreenshot = false;
+		while (isLooping)
+		{
+			//--------- Get input events ---------
+			SDL_Event e;
+			while (SDL_PollEvent(&e))
+			{
+				switch (e.type)
+				{
+				case SDL_QUIT:
+					isLooping = false;
+					break;
+				case SDL_KEYUP:
+					if (e.key.keysym.scancode == SDL_SCANCODE_X)
+						takeScreenshot = true;
+					if (e.key.keysym.scancode == SDL_SCANCODE_F2)
+						pRenderer->ToggleShadows();
+					if (e.key.keysym.scancode == SDL_SCANCODE_F3)
+						pRenderer->CycleLightingMode();
+					if (e.key.keysym.scancode == SDL_SCANCODE_F4)
+						pRenderer->TogglePacketTracing();
+					if (e.key.keysym.scancode == SDL_SCANCODE_F5)
+						pRenderer->ToggleDeferredShading();
+					if (e.key.keysym.scancode == SDL_SCANCODE_F6)
+						pRenderer->ToggleSRGB();
+					if (e.key.keysym.scancode == SDL_SCANCODE_F7)
+						pRenderer->ToggleProgressiveRendering();
+					if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+						pScene->ToggleAnimation();
+					if (e.key.keysym.scancode == SDL_SCANCODE_F9)
+					{
+						isDynamicResolutionEnabled = not isDynamicResolutionEnabled;
+						std::cout << "[DYNAMIC RESOLUTION]:\t";
+						if (isDynamicResolutionEnabled)
+							std::cout << "ON\n";
+						else
+							std::cout << "OFF\n";
+
+						//Starts over from the highest scale, the full resolution when disabled
+						scaleController.Reset();
+						pRenderer->SetRenderScale(isDynamicResolutionEnabled ? scaleController.GetScale() : 1.f);
+					}
+					if (e.key.keysym.scancode == SDL_SCANCODE_F10)
+						pRenderer->ToggleAdaptiveAntiAliasing();
+					break;
+				}
+			}
+
+			//--------- Update ---------
+			pScene->Update(pTimer);
+			if (isRecordingCameraPath)
+			{
+				const Camera& camera{ pScene->GetCamera() };
+				recordedCameraPath.AddKeyframe({ pTimer->GetTotal(), camera.origin, camera.totalPitch, camera.totalYaw });
+			}
+
+			//--------- Render ---------
+			pRenderer->Render(pScene.get());
+			if constexpr (RAY_STATISTICS_ENABLED)
+				printStatistics += pRenderer->GetRayStatistics();
+
+			//--------- Timer ---------
+			pTimer->Update();
+			if (isDynamicResolutionEnabled)
+			{
+				scaleController.Update(pTimer->GetElapsed());
+				pRenderer->SetRenderScale(scaleController.GetScale());
+			}
+			printTimer += pTimer->GetElapsed();
+			if (printTimer >= 1.f)
+			{
+				std::cout << "dFPS: " << pTimer->GetdFPS() << " [" << GetIsaLevelName(pRenderer->GetIsaLevel()) << "]";
+				if (isDynamicResolutionEnabled)
+					PrintRenderScale(*pRenderer, scaleController);
+				std::cout << std::endl;
+				if constexpr (RAY_STATISTICS_ENABLED)
+				{
+					//Rays per second of wall clock time since the previous print
+					PrintRayStatistics(printStatistics, printTimer);
+					printStatistics = {};
+				}
+				printTimer = 0.f;
+			}
+
+			//Save screenshot after full render
+			if (takeScreenshot)
+			{
+				if (!pRenderer->SaveBufferToImage())
+					std::cout << "Screenshot saved!" << std::endl;
+				else
+					std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
+				takeScreenshot = false;
+			}
+		}
+		pTimer->Stop();
+
+		if (isRecordingCameraPath)
+		{
+			if (recordedCameraPath.SaveToFile(options.recordCameraPathFile))
+				std::cout << "Camera path saved to " << options.recordCameraPathFile << std::endl;
+			else
+				std::cout << "Could not write camera path " << options.recordCameraPathFile << std::endl;
+		}
+
+		//Shutdown "framework"
+		delete pRenderer;
+		delete pTimer;
+
+		SDL_DestroyWindow(pWindow);
+		return 0;
+	}
+}
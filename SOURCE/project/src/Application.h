@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "CpuFeatures.h"
+
+//Everything the command line can set, parsed in main.cpp
+struct CommandLineOptions final
+{
+	bool headless{ false };
+	std::string sceneName{ "reference" };
+	uint32_t width{ 640 };
+	uint32_t height{ 480 };
+	//0: one frame in headless mode, the whole camera path in benchmark mode
+	uint32_t frameCount{ 0 };
+	std::string outputPath{ "frame" };
+	bool rawOutput{ false };
+	uint32_t threadCount{ 0 };
+	uint32_t tileSize{ 0 };
+	bool deferredShading{ false };
+	bool sRGB{ false };
+	bool progressive{ false };
+	bool animation{ true };
+	bool adaptiveAA{ false };
+	uint32_t antiAliasingRayBudget{ 0 };
+	bool dynamicResolution{ false };
+	float targetFrameTime{ 16.6f };
+	float minScale{ 0.5f };
+	float maxScale{ 1.f };
+	//Empty: the highest level the cpu supports
+	std::string isaLevel{};
+	//Benchmark mode writes its report here, the camera follows cameraPathFile (empty: a built in fly through) with a fixed time step
+	std::string benchmarkPath{};
+	std::string cameraPathFile{};
+	float timeStep{ 1000.f / 60.f };
+	uint32_t warmupFrameCount{ 3 };
+	//Windowed mode writes the camera path it flew here on exit
+	std::string recordCameraPathFile{};
+};
+
+namespace dae
+{
+	//Runs the renderer until the window is closed or all headless or benchmark frames are done, returns the exit code
+	//isaLevel selects the kernels the renderer uses, main.cpp picks it
+	int RunHeadless(const CommandLineOptions& options, IsaLevel isaLevel);
+	int RunBenchmark(const CommandLineOptions& options, IsaLevel isaLevel);
+	int RunWindowed(const CommandLineOptions& options, IsaLevel isaLevel);
+}
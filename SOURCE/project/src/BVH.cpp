@@ -0,0 +1,230 @@
+#include "BVH.h"
+
+namespace dae
+{
+	void BVH::Build(const std::vector<AABB>& primitiveBounds, uint32_t primitiveBlockSize)
+	{
+		Clear();
+		m_PrimitiveBlockSize = std::max(primitiveBlockSize, 1u);
+		if (primitiveBounds.empty())
+			return;
+
+		const uint32_t primitiveCount{ static_cast<uint32_t>(primitiveBounds.size()) };
+
+		//Centroids are only needed while building
+		std::vector<Vector3> centroids{};
+		centroids.reserve(primitiveCount);
+		m_PrimitiveIndices.reserve(primitiveCount);
+		for (uint32_t primitiveIndex{}; primitiveIndex < primitiveCount; ++primitiveIndex)
+		{
+			m_PrimitiveIndices.emplace_back(primitiveIndex);
+			centroids.emplace_back(primitiveBounds[primitiveIndex].GetCenter());
+		}
+
+		//A binary tree with N leaves never has more than 2N - 1 nodes
+		m_Nodes.reserve(2 * static_cast<size_t>(primitiveCount) - 1);
+
+		BVHNode& root{ m_Nodes.emplace_back() };
+		root.leftFirst = 0;
+		root.primitiveCount = primitiveCount;
+
+		UpdateNodeBounds(0, primitiveBounds);
+		Subdivide(0, primitiveBounds, centroids, 1);
+
+		m_BuildSAHCost = GetSAHCost();
+	}
+
+	bool BVH::Refit(const std::vector<AABB>& primitiveBounds)
+	{
+		if (primitiveBounds.size() != m_PrimitiveIndices.size())
+		{
+			Build(primitiveBounds, m_PrimitiveBlockSize);
+			return true;
+		}
+
+		//Children are always stored after their parent, so walking backwards visits them first
+		for (size_t nodeIndex{ m_Nodes.size() }; nodeIndex-- > 0;)
+		{
+			BVHNode& node{ m_Nodes[nodeIndex] };
+			if (node.IsLeaf())
+			{
+				UpdateNodeBounds(static_cast<uint32_t>(nodeIndex), primitiveBounds);
+				continue;
+			}
+
+			node.bounds = m_Nodes[node.leftFirst].bounds;
+			node.bounds.Grow(m_Nodes[node.leftFirst + 1].bounds);
+		}
+
+		if (GetSAHCost() > m_BuildSAHCost * REBUILD_COST_RATIO)
+		{
+			Build(primitiveBounds, m_PrimitiveBlockSize);
+			return true;
+		}
+		return false;
+	}
+
+	float BVH::GetSAHCost() const
+	{
+		if (m_Nodes.empty())
+			return 0.f;
+
+		const float rootArea{ m_Nodes[0].bounds.GetSurfaceArea() };
+		if (rootArea <= 0.f)
+			return 0.f;
+
+		//Same relative costs as used while building: 1 per traversal step, 1 per primitive block test
+		float cost{};
+		for (const BVHNode& node : m_Nodes)
+		{
+			const float primitiveCost{ node.IsLeaf() ? GetPrimitiveCost(node.primitiveCount) : 1.f };
+			cost += primitiveCost * node.bounds.GetSurfaceArea();
+		}
+
+		return cost / rootArea;
+	}
+
+	void BVH::Clear()
+	{
+		m_Nodes.clear();
+		m_PrimitiveIndices.clear();
+	}
+
+	void BVH::UpdateNodeBounds(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds)
+	{
+		BVHNode& node{ m_Nodes[nodeIndex] };
+		node.bounds = AABB{};
+
+		for (uint32_t index{}; index < node.primitiveCount; ++index)
+		{
+			node.bounds.Grow(primitiveBounds[m_PrimitiveIndices[node.leftFirst + index]]);
+		}
+	}
+
+	void BVH::Subdivide(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds, const std::vector<Vector3>& centroids, uint32_t depth)
+	{
+		if (m_Nodes[nodeIndex].primitiveCount <= 1 || depth >= BVH_MAX_DEPTH)
+			return;
+
+		//Only split when it is cheaper than intersecting all primitives of this node
+		int axis{};
+		float splitPosition{};
+		const float splitCost{ FindBestSplit(m_Nodes[nodeIndex], primitiveBounds, centroids, axis, splitPosition) };
+		const float leafCost{ m_Nodes[nodeIndex].bounds.GetSurfaceArea() * GetPrimitiveCost(m_Nodes[nodeIndex].primitiveCount) };
+		if (splitCost >= leafCost)
+			return;
+
+		const uint32_t firstPrimitive{ m_Nodes[nodeIndex].leftFirst };
+		const uint32_t primitiveCount{ m_Nodes[nodeIndex].primitiveCount };
+
+		//Partition primitives in place (left of the split plane <> right of the split plane)
+		int i{ static_cast<int>(firstPrimitive) };
+		int j{ i + static_cast<int>(primitiveCount) - 1 };
+		while (i <= j)
+		{
+			if (centroids[m_PrimitiveIndices[i]][axis] < splitPosition)
+				++i;
+			else
+				std::swap(m_PrimitiveIndices[i], m_PrimitiveIndices[j--]);
+		}
+
+		//Split did not separate anything (can happen due to floating point precision)
+		const uint32_t leftCount{ static_cast<uint32_t>(i) - firstPrimitive };
+		if (leftCount == 0 || leftCount == primitiveCount)
+			return;
+
+		const uint32_t leftChildIndex{ static_cast<uint32_t>(m_Nodes.size()) };
+		const uint32_t rightChildIndex{ leftChildIndex + 1 };
+
+		BVHNode& leftChild{ m_Nodes.emplace_back() };
+		leftChild.leftFirst = firstPrimitive;
+		leftChild.primitiveCount = leftCount;
+
+		BVHNode& rightChild{ m_Nodes.emplace_back() };
+		rightChild.leftFirst = static_cast<uint32_t>(i);
+		rightChild.primitiveCount = primitiveCount - leftCount;
+
+		m_Nodes[nodeIndex].leftFirst = leftChildIndex;
+		m_Nodes[nodeIndex].primitiveCount = 0;
+
+		UpdateNodeBounds(leftChildIndex, primitiveBounds);
+		UpdateNodeBounds(rightChildIndex, primitiveBounds);
+
+		Subdivide(leftChildIndex, primitiveBounds, centroids, depth + 1);
+		Subdivide(rightChildIndex, primitiveBounds, centroids, depth + 1);
+	}
+
+	float BVH::FindBestSplit(const BVHNode& node, const std::vector<AABB>& primitiveBounds, const std::vector<Vector3>& centroids, int& axis, float& splitPosition) const
+	{
+		struct Bin
+		{
+			AABB bounds{};
+			uint32_t primitiveCount{};
+		};
+
+		float bestCost{ FLT_MAX };
+		for (int currentAxis{}; currentAxis < 3; ++currentAxis)
+		{
+			//Bins are spread over the bounds of the centroids, not over the node bounds
+			float boundsMin{ FLT_MAX };
+			float boundsMax{ -FLT_MAX };
+			for (uint32_t index{}; index < node.primitiveCount; ++index)
+			{
+				const float centroid{ centroids[m_PrimitiveIndices[node.leftFirst + index]][currentAxis] };
+				boundsMin = std::min(boundsMin, centroid);
+				boundsMax = std::max(boundsMax, centroid);
+			}
+			if (boundsMin == boundsMax)
+				continue;
+
+			//Fill bins
+			Bin bins[BIN_COUNT]{};
+			const float binScale{ static_cast<float>(BIN_COUNT) / (boundsMax - boundsMin) };
+			for (uint32_t index{}; index < node.primitiveCount; ++index)
+			{
+				const uint32_t primitiveIndex{ m_PrimitiveIndices[node.leftFirst + index] };
+				const float centroid{ centroids[primitiveIndex][currentAxis] };
+				const uint32_t binIndex{ std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroid - boundsMin) * binScale)) };
+
+				++bins[binIndex].primitiveCount;
+				bins[binIndex].bounds.Grow(primitiveBounds[primitiveIndex]);
+			}
+
+			//Sweep from both sides to get counts and areas for every plane between two bins
+			float leftArea[BIN_COUNT - 1]{}, rightArea[BIN_COUNT - 1]{};
+			uint32_t leftCount[BIN_COUNT - 1]{}, rightCount[BIN_COUNT - 1]{};
+			AABB leftBox{}, rightBox{};
+			uint32_t leftSum{}, rightSum{};
+			for (uint32_t plane{}; plane < BIN_COUNT - 1; ++plane)
+			{
+				leftSum += bins[plane].primitiveCount;
+				leftCount[plane] = leftSum;
+				leftBox.Grow(bins[plane].bounds);
+				leftArea[plane] = leftBox.GetSurfaceArea();
+
+				rightSum += bins[BIN_COUNT - 1 - plane].primitiveCount;
+				rightCount[BIN_COUNT - 2 - plane] = rightSum;
+				rightBox.Grow(bins[BIN_COUNT - 1 - plane].bounds);
+				rightArea[BIN_COUNT - 2 - plane] = rightBox.GetSurfaceArea();
+			}
+
+			//Evaluate SAH for every plane
+			const float binWidth{ (boundsMax - boundsMin) / static_cast<float>(BIN_COUNT) };
+			for (uint32_t plane{}; plane < BIN_COUNT - 1; ++plane)
+			{
+				if (leftCount[plane] == 0 || rightCount[plane] == 0)
+					continue;
+
+				const float planeCost{ GetPrimitiveCost(leftCount[plane]) * leftArea[plane] + GetPrimitiveCost(rightCount[plane]) * rightArea[plane] };
+				if (planeCost < bestCost)
+				{
+					axis = currentAxis;
+					splitPosition = boundsMin + binWidth * static_cast<float>(plane + 1);
+					bestCost = planeCost;
+				}
+			}
+		}
+
+		return bestCost;
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Math.h"
+
+namespace dae
+{
+	//Upper bound for the depth of a BVH, traversal stacks can be sized with this
+	constexpr uint32_t BVH_MAX_DEPTH{ 64 };
+
+	struct AABB final
+	{
+		Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(const Vector3& point)
+		{
+			min = Vector3::Min(min, point);
+			max = Vector3::Max(max, point);
+		}
+
+		void Grow(const AABB& other)
+		{
+			min = Vector3::Min(min, other.min);
+			max = Vector3::Max(max, other.max);
+		}
+
+		Vector3 GetCenter() const
+		{
+			return (min + max) * 0.5f;
+		}
+
+		//Squared distance from a point to the closest point of the box (0 when the point is inside)
+		float GetSqrDistance(const Vector3& point) const
+		{
+			const Vector3 outside{ Vector3::Max(Vector3::Max(min - point, point - max), Vector3::Zero) };
+			return outside.SqrMagnitude();
+		}
+
+		float GetSurfaceArea() const
+		{
+			//Empty box (nothing grown into it yet)
+			if (min.x > max.x) return 0.f;
+
+			const Vector3 extent{ max - min };
+			return 2.f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+		}
+	};
+
+	struct BVHNode final
+	{
+		AABB bounds{};
+
+		//Inner node: index of the left child, the right child is always stored right after it
+		//Leaf node: index of the first primitive in the primitive index list
+		uint32_t leftFirst{};
+		uint32_t primitiveCount{};
+
+		bool IsLeaf() const { return primitiveCount > 0; }
+	};
+
+	//Bounding Volume Hierarchy built with binned SAH (Surface Area Heuristic)
+	//Works on primitive bounds only, so it can be used for any kind of primitive
+	class BVH final
+	{
+	public:
+		//primitiveBlockSize: primitives that are intersected together (SIMD), leaves are sized with this in mind
+		void Build(const std::vector<AABB>& primitiveBounds, uint32_t primitiveBlockSize = 1);
+		void Clear();
+
+		//Recomputes node bounds bottom-up for primitives that moved, the topology stays the same
+		//Falls back to a full build when the primitive count changed or when the SAH cost degraded too much
+		//Returns true when a full build was done
+		bool Refit(const std::vector<AABB>& primitiveBounds);
+		float GetSAHCost() const;
+		//Refit rebuilds the tree once its SAH cost is above this
+		float GetRebuildSAHCost() const { return m_BuildSAHCost * REBUILD_COST_RATIO; }
+
+		bool IsEmpty() const { return m_Nodes.empty(); }
+		const std::vector<BVHNode>& GetNodes() const { return m_Nodes; }
+		const std::vector<uint32_t>& GetPrimitiveIndices() const { return m_PrimitiveIndices; }
+
+	private:
+		static constexpr uint32_t BIN_COUNT{ 8 };
+		//Rebuild when refitting made the tree this much more expensive than right after building it
+		static constexpr float REBUILD_COST_RATIO{ 1.5f };
+
+		std::vector<BVHNode> m_Nodes{};
+		std::vector<uint32_t> m_PrimitiveIndices{};
+		float m_BuildSAHCost{};
+		uint32_t m_PrimitiveBlockSize{ 1 };
+
+		//Cost of intersecting a number of primitives, partially filled blocks cost as much as full ones
+		float GetPrimitiveCost(uint32_t primitiveCount) const
+		{
+			return static_cast<float>((primitiveCount + m_PrimitiveBlockSize - 1) / m_PrimitiveBlockSize);
+		}
+
+		void UpdateNodeBounds(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds);
+		void Subdivide(uint32_t nodeIndex, const std::vector<AABB>& primitiveBounds, const std::vector<Vector3>& centroids, uint32_t depth);
+		float FindBestSplit(const BVHNode& node, const std::vector<AABB>& primitiveBounds, const std::vector<Vector3>& centroids, int& axis, float& splitPosition) const;
+	};
+
+	/**
+	 * \brief Groups the primitives of every leaf in blocks (SIMD), blocks follow the leaf order of the BVH
+	 * Every leaf starts a new block, the first block of a leaf is stored in leafFirstBlock[nodeIndex]
+	 * \param setLane called as setLane(block, lane, primitiveIndex) for every primitive
+	 */
+	template<typename Block, typename LaneSetter>
+	void BuildLeafBlocks(const BVH& bvh, uint32_t blockWidth, std::vector<Block>& blocks, std::vector<uint32_t>& leafFirstBlock, LaneSetter&& setLane)
+	{
+		blocks.clear();
+
+		const std::vector<BVHNode>& nodes{ bvh.GetNodes() };
+		const std::vector<uint32_t>& primitiveIndices{ bvh.GetPrimitiveIndices() };
+		leafFirstBlock.assign(nodes.size(), 0);
+
+		for (size_t nodeIndex{}; nodeIndex < nodes.size(); ++nodeIndex)
+		{
+			const BVHNode& node{ nodes[nodeIndex] };
+			if (!node.IsLeaf()) continue;
+
+			leafFirstBlock[nodeIndex] = static_cast<uint32_t>(blocks.size());
+			for (uint32_t index{}; index < node.primitiveCount; ++index)
+			{
+				const uint32_t lane{ index % blockWidth };
+				if (lane == 0) blocks.emplace_back();
+
+				setLane(blocks.back(), lane, primitiveIndices[node.leftFirst + index]);
+			}
+		}
+	}
+}
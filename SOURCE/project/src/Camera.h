@@ -38,9 +38,11 @@ namespace dae
 			return cameraToWorld;
 		}
 
-		void Update(Timer* pTimer)
+		//Returns true when the camera moved or rotated
+		bool Update(Timer* pTimer)
 		{
 			const float deltaTime = pTimer->GetElapsed();
+			bool hasMoved{ false };
 
 			//Keyboard Input
 			const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
@@ -53,6 +55,7 @@ namespace dae
 
 				origin += static_cast<float>(forwardMove) * forward * keyboardMovementSpeed * deltaTime;
 				origin += static_cast<float>(rightMove) * right * keyboardMovementSpeed * deltaTime;
+				hasMoved = true;
 			}
 
 
@@ -62,6 +65,9 @@ namespace dae
 
 			int mouseX{}, mouseY{};
 			const uint32_t mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+			if ((mouseX || mouseY) && (mouseState & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK)))
+				hasMoved = true;
+
 			if (mouseState == (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK))
 			{
 				//Moves up and down
@@ -84,6 +90,8 @@ namespace dae
 			const Matrix finalRotation{ Matrix::CreateRotation(totalPitch, totalYaw, 0.f) };
 			forward = finalRotation.TransformVector(Vector3::UnitZ);
 			forward.Normalize();
+
+			return hasMoved;
 		}
 	};
 }
@@ -0,0 +1,112 @@
+#include "CameraPath.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include "Camera.h"
+
+namespace dae
+{
+	bool CameraPath::LoadFromFile(const std::string& filePath)
+	{
+		std::ifstream file{ filePath };
+		if (!file)
+			return false;
+
+		m_Keyframes.clear();
+		std::string line{};
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			std::istringstream lineStream{ line };
+			CameraKeyframe keyframe{};
+			if (!(lineStream >> keyframe.time >> keyframe.origin.x >> keyframe.origin.y >> keyframe.origin.z >> keyframe.pitch >> keyframe.yaw))
+				return false;
+			AddKeyframe(keyframe);
+		}
+		return !m_Keyframes.empty();
+	}
+
+	bool CameraPath::SaveToFile(const std::string& filePath) const
+	{
+		std::ofstream file{ filePath };
+		if (!file)
+			return false;
+
+		file << "#time originX originY originZ pitch yaw\n";
+		for (const CameraKeyframe& keyframe : m_Keyframes)
+		{
+			file << keyframe.time << " " << keyframe.origin.x << " " << keyframe.origin.y << " " << keyframe.origin.z
+				<< " " << keyframe.pitch << " " << keyframe.yaw << "\n";
+		}
+		return static_cast<bool>(file);
+	}
+
+	void CameraPath::AddKeyframe(const CameraKeyframe& keyframe)
+	{
+		if (!m_Keyframes.empty() && keyframe.time < m_Keyframes.back().time)
+			return;
+		m_Keyframes.push_back(keyframe);
+	}
+
+	void CameraPath::CreateFlyThrough(const Camera& camera)
+	{
+		//Offsets in camera space (right, up, forward), sways left and right so the view crosses the whole scene
+		struct FlyThroughKey final
+		{
+			float time;
+			Vector3 offset;
+			float pitch;
+			float yaw;
+		};
+		static const FlyThroughKey keys[]
+		{
+			{ 0.f, { 0.f, 0.f, 0.f }, 0.f, 0.f },
+			{ 1.f, { 2.f, 0.f, 3.f }, 0.f, -0.3f },
+			{ 2.f, { 0.f, 1.f, 5.f }, 0.2f, 0.f },
+			{ 3.f, { -2.f, 0.f, 3.f }, 0.f, 0.3f },
+			{ 4.f, { 0.f, 0.f, 0.f }, 0.f, 0.f }
+		};
+
+		m_Keyframes.clear();
+		for (const FlyThroughKey& key : keys)
+		{
+			const Vector3 origin{ camera.origin + camera.right * key.offset.x + camera.up * key.offset.y + camera.forward * key.offset.z };
+			AddKeyframe({ key.time, origin, camera.totalPitch + key.pitch, camera.totalYaw + key.yaw });
+		}
+	}
+
+	float CameraPath::GetDuration() const
+	{
+		if (m_Keyframes.empty())
+			return 0.f;
+		return m_Keyframes.back().time - m_Keyframes.front().time;
+	}
+
+	CameraKeyframe CameraPath::Sample(float time) const
+	{
+		if (m_Keyframes.empty())
+			return {};
+
+		const float pathTime{ m_Keyframes.front().time + time };
+		if (pathTime <= m_Keyframes.front().time)
+			return m_Keyframes.front();
+		if (pathTime >= m_Keyframes.back().time)
+			return m_Keyframes.back();
+
+		//First keyframe after pathTime, the one before it exists because of the checks above
+		const auto nextIt{ std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), pathTime,
+			[](float value, const CameraKeyframe& keyframe) { return value < keyframe.time; }) };
+		const CameraKeyframe& next{ *nextIt };
+		const CameraKeyframe& previous{ *(nextIt - 1) };
+
+		const float factor{ (pathTime - previous.time) / std::max(next.time - previous.time, 1e-6f) };
+		return CameraKeyframe{
+			pathTime,
+			previous.origin + (next.origin - previous.origin) * factor,
+			Lerpf(previous.pitch, next.pitch, factor),
+			Lerpf(previous.yaw, next.yaw, factor)
+		};
+	}
+}
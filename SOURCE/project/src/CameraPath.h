@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Math.h"
+
+namespace dae
+{
+	struct Camera;
+
+	//Camera pose at a point in time, pitch and yaw in radians like Camera::totalPitch and Camera::totalYaw
+	struct CameraKeyframe final
+	{
+		float time{};
+		Vector3 origin{};
+		float pitch{};
+		float yaw{};
+	};
+
+	//Keyframes the camera follows during a benchmark, the pose between two keyframes is interpolated linearly
+	//File format, one keyframe per line: time originX originY originZ pitch yaw (lines starting with # are skipped)
+	class CameraPath final
+	{
+	public:
+		CameraPath() = default;
+		~CameraPath() = default;
+
+		CameraPath(const CameraPath&) = delete;
+		CameraPath(CameraPath&&) noexcept = delete;
+		CameraPath& operator=(const CameraPath&) = delete;
+		CameraPath& operator=(CameraPath&&) noexcept = delete;
+
+		//Both return false when the file could not be read or written, a loaded path needs at least one keyframe
+		bool LoadFromFile(const std::string& filePath);
+		bool SaveToFile(const std::string& filePath) const;
+
+		//Keyframes have to be added in time order, a keyframe that goes back in time is ignored
+		void AddKeyframe(const CameraKeyframe& keyframe);
+		//Replaces the keyframes by a short flight into the scene in front of the camera and back
+		void CreateFlyThrough(const Camera& camera);
+
+		bool IsEmpty() const { return m_Keyframes.empty(); }
+		//Time between the first and the last keyframe in seconds
+		float GetDuration() const;
+		//time is relative to the first keyframe, the path holds its first and last pose outside of its duration
+		CameraKeyframe Sample(float time) const;
+
+	private:
+		std::vector<CameraKeyframe> m_Keyframes{};
+	};
+}
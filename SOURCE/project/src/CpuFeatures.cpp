@@ -0,0 +1,94 @@
+#include "CpuFeatures.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		//eax, ebx, ecx, edx of a CPUID leaf, all 0 when the leaf doesn't exist
+		struct CpuidResult final
+		{
+			uint32_t eax, ebx, ecx, edx;
+		};
+
+		CpuidResult Cpuid(uint32_t leaf, uint32_t subLeaf)
+		{
+			CpuidResult result{};
+#if defined(_MSC_VER)
+			int registers[4]{};
+			__cpuidex(registers, static_cast<int>(leaf), static_cast<int>(subLeaf));
+			result = { static_cast<uint32_t>(registers[0]), static_cast<uint32_t>(registers[1]), static_cast<uint32_t>(registers[2]), static_cast<uint32_t>(registers[3]) };
+#else
+			if (!__get_cpuid_count(leaf, subLeaf, &result.eax, &result.ebx, &result.ecx, &result.edx))
+				result = {};
+#endif
+			return result;
+		}
+
+		//Register state the operating system saves on a context switch
+		uint64_t GetEnabledRegisterState()
+		{
+#if defined(_MSC_VER)
+			return _xgetbv(0);
+#else
+			uint32_t eax, edx;
+			__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+		}
+#endif
+	}
+
+	bool ParseIsaLevel(const char* name, IsaLevel& level)
+	{
+		if (std::strcmp(name, "sse4") == 0)
+			level = IsaLevel::SSE4;
+		else if (std::strcmp(name, "avx2") == 0)
+			level = IsaLevel::AVX2;
+		else
+			return false;
+		return true;
+	}
+
+	bool IsCpuSupported()
+	{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		//The instruction sets of the SSE4 kernels (SIMD_TARGETS_SSE4): SSE4.1, SSE4.2 and POPCNT
+		constexpr uint32_t sse4Bits{ (1u << 19) | (1u << 20) | (1u << 23) };
+		return (Cpuid(1, 0).ecx & sse4Bits) == sse4Bits;
+#else
+		//No target regions, the kernels are compiled for the baseline
+		return true;
+#endif
+	}
+
+	IsaLevel GetSupportedIsaLevel()
+	{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		const uint32_t maxLeaf{ Cpuid(0, 0).eax };
+		const CpuidResult features{ Cpuid(1, 0) };
+		const CpuidResult extendedFeatures{ maxLeaf >= 7 ? Cpuid(7, 0) : CpuidResult{} };
+
+		//AVX needs the operating system to save the ymm registers
+		const bool hasOSXSave{ (features.ecx & (1u << 27)) != 0 };
+		const uint64_t registerState{ hasOSXSave ? GetEnabledRegisterState() : 0 };
+		//xmm and ymm state
+		const bool isAVXStateEnabled{ (registerState & 0x6) == 0x6 };
+
+		const bool hasAVX2{ isAVXStateEnabled && (features.ecx & (1u << 12)) != 0 //FMA
+			&& (features.ecx & (1u << 28)) != 0 //AVX
+			&& (extendedFeatures.ebx & (1u << 5)) != 0 }; //AVX2
+		if (hasAVX2)
+			return IsaLevel::AVX2;
+#endif
+		return IsaLevel::SSE4;
+	}
+}
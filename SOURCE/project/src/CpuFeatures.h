@@ -0,0 +1,31 @@
+#pragma once
+
+namespace dae
+{
+	//Instruction set levels the kernels are compiled for, in increasing order
+	//There is no AVX-512 level: the primitive blocks are 8 wide for every level, so 16 lanes would only fit by changing the BVH leaves
+	//of all levels, and the 8 wide kernels recompiled for AVX-512VL run about as fast as the AVX2 ones. AVX-512 cpus use AVX2
+	enum class IsaLevel
+	{
+		SSE4,
+		AVX2
+	};
+
+	inline const char* GetIsaLevelName(IsaLevel level)
+	{
+		switch (level)
+		{
+		case IsaLevel::AVX2:
+			return "AVX2";
+		default:
+			return "SSE4";
+		}
+	}
+
+	//sse4 or avx2, returns false for anything else
+	bool ParseIsaLevel(const char* name, IsaLevel& level);
+	//False when the cpu lacks an instruction set of the lowest level (SSE4.1, SSE4.2 or POPCNT), no kernels can run then
+	bool IsCpuSupported();
+	//Highest level both the cpu (CPUID) and the operating system (saved register state, XGETBV) support
+	IsaLevel GetSupportedIsaLevel();
+}
@@ -1,7 +1,11 @@
 #pragma once
+#include <iterator>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 #include "Math.h"
+#include "BVH.h"
+#include "SIMD.h"
 
 namespace dae
 {
@@ -53,31 +57,194 @@ namespace dae
 		unsigned char materialIndex{};
 	};
 
+	//Precomputed triangle data for the Möller-Trumbore intersection, only used to fill a lane of a TriangleBlock
+	struct TriangleRecord final
+	{
+		Vector3 v0{};
+		Vector3 edge1{}; //v0 -> v1
+		Vector3 edge2{}; //v0 -> v2
+		Vector3 normal{};
+	};
+
+	//Primitives that are stored together (SoA) and intersected with one ray at once
+	//Fixed for every instruction set level, a narrower level tests a block in SIMD::WIDTH parts
+	constexpr uint32_t PRIMITIVE_BLOCK_WIDTH{ SIMD::MAX_WIDTH };
+
+	//BVHs with up to this many blocks are not traversed, all blocks are tested instead
+	constexpr size_t SMALL_BVH_BLOCK_COUNT{ 2 };
+
+	//Unused lanes are degenerate (all zero) triangles that can never be hit
+	struct alignas(32) TriangleBlock final
+	{
+		float v0X[PRIMITIVE_BLOCK_WIDTH]{}, v0Y[PRIMITIVE_BLOCK_WIDTH]{}, v0Z[PRIMITIVE_BLOCK_WIDTH]{};
+		float edge1X[PRIMITIVE_BLOCK_WIDTH]{}, edge1Y[PRIMITIVE_BLOCK_WIDTH]{}, edge1Z[PRIMITIVE_BLOCK_WIDTH]{};
+		float edge2X[PRIMITIVE_BLOCK_WIDTH]{}, edge2Y[PRIMITIVE_BLOCK_WIDTH]{}, edge2Z[PRIMITIVE_BLOCK_WIDTH]{};
+		float normalX[PRIMITIVE_BLOCK_WIDTH]{}, normalY[PRIMITIVE_BLOCK_WIDTH]{}, normalZ[PRIMITIVE_BLOCK_WIDTH]{};
+
+		void SetLane(uint32_t lane, const TriangleRecord& triangle)
+		{
+			v0X[lane] = triangle.v0.x; v0Y[lane] = triangle.v0.y; v0Z[lane] = triangle.v0.z;
+			edge1X[lane] = triangle.edge1.x; edge1Y[lane] = triangle.edge1.y; edge1Z[lane] = triangle.edge1.z;
+			edge2X[lane] = triangle.edge2.x; edge2Y[lane] = triangle.edge2.y; edge2Z[lane] = triangle.edge2.z;
+			normalX[lane] = triangle.normal.x; normalY[lane] = triangle.normal.y; normalZ[lane] = triangle.normal.z;
+		}
+	};
+
+	//Unused lanes have a negative squared radius, so the discriminant is always negative
+	struct alignas(32) SphereBlock final
+	{
+		SphereBlock() { std::fill(std::begin(radiusSqrd), std::end(radiusSqrd), -1.f); }
+
+		float originX[PRIMITIVE_BLOCK_WIDTH]{}, originY[PRIMITIVE_BLOCK_WIDTH]{}, originZ[PRIMITIVE_BLOCK_WIDTH]{};
+		float radiusSqrd[PRIMITIVE_BLOCK_WIDTH];
+		uint32_t sphereIndex[PRIMITIVE_BLOCK_WIDTH]{};
+
+		void SetLane(uint32_t lane, const Sphere& sphere, uint32_t index)
+		{
+			originX[lane] = sphere.origin.x; originY[lane] = sphere.origin.y; originZ[lane] = sphere.origin.z;
+			radiusSqrd[lane] = sphere.radius * sphere.radius;
+			sphereIndex[lane] = index;
+		}
+	};
+
+	//Planes as normal + distance from the world origin (origin dot normal)
+	//Unused lanes have a zero normal, which results in a nan t value that is never a hit
+	struct alignas(32) PlaneBlock final
+	{
+		float normalX[PRIMITIVE_BLOCK_WIDTH]{}, normalY[PRIMITIVE_BLOCK_WIDTH]{}, normalZ[PRIMITIVE_BLOCK_WIDTH]{};
+		float distance[PRIMITIVE_BLOCK_WIDTH]{};
+		uint32_t planeIndex[PRIMITIVE_BLOCK_WIDTH]{};
+
+		void SetLane(uint32_t lane, const Plane& plane, uint32_t index)
+		{
+			normalX[lane] = plane.normal.x; normalY[lane] = plane.normal.y; normalZ[lane] = plane.normal.z;
+			distance[lane] = Vector3::Dot(plane.origin, plane.normal);
+			planeIndex[lane] = index;
+		}
+	};
+
+	//Object space geometry of a mesh, shared by every TriangleMesh instance created from it
+	struct TriangleMeshData final
+	{
+		std::vector<Vector3> positions{};
+		std::vector<Vector3> normals{};
+		std::vector<int> indices{};
+
+		Vector3 minAABB;
+		Vector3 maxAABB;
+
+		//Acceleration structure over the object space triangles (primitive index == triangle index)
+		BVH bvh{};
+		std::vector<AABB> triangleBounds{};
+
+		//The blocks are the only copy of the precomputed triangles (no separate records are kept)
+		//Blocks follow the leaf order of the BVH, every leaf has its own blocks starting at leafFirstBlock[nodeIndex]
+		std::vector<TriangleBlock> triangleBlocks{};
+		std::vector<uint32_t> leafFirstBlock{};
+
+		//Increased every time the geometry changes, instances compare it to notice changes made through another instance
+		uint32_t version{};
+
+		void CalculateNormals()
+		{
+			//Triangles are saved as ID triplets
+			for (size_t tripletIndex{}; tripletIndex < indices.size(); tripletIndex+=3)
+			{
+				Vector3 a{ positions[indices[tripletIndex + 1]], positions[indices[tripletIndex]] };
+				Vector3 b{ positions[indices[tripletIndex + 2]], positions[indices[tripletIndex]]};
+
+				normals.push_back(Vector3::Cross(a, b).Normalized());
+			}
+		}
+
+		void UpdateAABB()
+		{
+			if (not positions.empty())
+			{
+				minAABB = positions[0];
+				maxAABB = positions[0];
+				for (auto& p : positions)
+				{
+					minAABB = Vector3::Min(p, minAABB);
+					maxAABB = Vector3::Max(p, maxAABB);
+				}
+			}
+		}
+
+		TriangleRecord GetTriangleRecord(size_t triangleIndex) const
+		{
+			const size_t tripletIndex{ triangleIndex * 3 };
+			const Vector3& v0{ positions[indices[tripletIndex]] };
+
+			TriangleRecord record{};
+			record.v0 = v0;
+			record.edge1 = positions[indices[tripletIndex + 1]] - v0;
+			record.edge2 = positions[indices[tripletIndex + 2]] - v0;
+			record.normal = normals[triangleIndex].Normalized();
+			return record;
+		}
+
+		void UpdateBVH()
+		{
+			triangleBounds.resize(indices.size() / 3);
+			for (size_t triangleIndex{}; triangleIndex < triangleBounds.size(); ++triangleIndex)
+			{
+				const size_t tripletIndex{ triangleIndex * 3 };
+				AABB& bounds{ triangleBounds[triangleIndex] };
+				bounds = AABB{};
+				bounds.Grow(positions[indices[tripletIndex]]);
+				bounds.Grow(positions[indices[tripletIndex + 1]]);
+				bounds.Grow(positions[indices[tripletIndex + 2]]);
+			}
+
+			//Only the first time a full build is needed, after that refitting is enough
+			//until the tree quality degrades too much (or triangles were added)
+			if (bvh.IsEmpty())
+				bvh.Build(triangleBounds, PRIMITIVE_BLOCK_WIDTH);
+			else
+				bvh.Refit(triangleBounds);
+		}
+
+		void UpdateTriangleBlocks()
+		{
+			BuildLeafBlocks(bvh, PRIMITIVE_BLOCK_WIDTH, triangleBlocks, leafFirstBlock, [&](TriangleBlock& block, uint32_t lane, uint32_t triangleIndex)
+			{
+				block.SetLane(lane, GetTriangleRecord(triangleIndex));
+			});
+		}
+	};
+
 	struct TriangleMesh final
 	{
 		TriangleMesh() = default;
 		TriangleMesh(const std::vector<Vector3>& _positions, const std::vector<int>& _indices, TriangleCullMode _cullMode) :
-			positions(_positions), indices(_indices), cullMode(_cullMode)
+			cullMode(_cullMode)
 		{
+			pData->positions = _positions;
+			pData->indices = _indices;
+
 			//Calculate Normals
 			CalculateNormals();
 
+			UpdateAABB();
+
 			//Update Transforms
 			UpdateTransforms();
-
-			UpdateAABB();
 		}
 
 		TriangleMesh(const std::vector<Vector3>& _positions, const std::vector<int>& _indices, const std::vector<Vector3>& _normals, TriangleCullMode _cullMode) :
-			positions(_positions), indices(_indices), normals(_normals), cullMode(_cullMode)
+			cullMode(_cullMode)
 		{
-			UpdateTransforms();
+			pData->positions = _positions;
+			pData->indices = _indices;
+			pData->normals = _normals;
+
 			UpdateAABB();
+			UpdateTransforms();
 		}
 
-		std::vector<Vector3> positions{};
-		std::vector<Vector3> normals{};
-		std::vector<int> indices{};
+		//Geometry stays in object space, copies of a mesh (instances) share it
+		std::shared_ptr<TriangleMeshData> pData{ std::make_shared<TriangleMeshData>() };
 		unsigned char materialIndex{};
 
 		TriangleCullMode cullMode{ TriangleCullMode::BackFaceCulling };
@@ -86,106 +253,103 @@ namespace dae
 		Matrix translationTransform{};
 		Matrix scaleTransform{};
 
-		Vector3 minAABB;
-		Vector3 maxAABB;
+		//Rays are transformed to object space instead of transforming the geometry to world space
+		Matrix worldToObject{};
+		//Inverse transpose of the final transform, keeps normals perpendicular under non-uniform scale
+		Matrix normalToWorld{};
 
 		Vector3 transformedMinAABB;
 		Vector3 transformedMaxAABB;
 
-		std::vector<Vector3> transformedPositions{};
-		std::vector<Vector3> transformedNormals{};
+		//Increased every time UpdateTransforms changes the world transform, lets the scene track moved meshes
+		uint32_t transformVersion{};
+		//Set by the transform functions, UpdateTransforms does nothing while it is false and dataVersion is up to date
+		bool isTransformDirty{ true };
+		//pData->version the world bounds were calculated with
+		uint32_t dataVersion{};
 
 		void Translate(const Vector3& translation)
 		{
 			translationTransform = Matrix::CreateTranslation(translation);
+			isTransformDirty = true;
 		}
 
 		void RotateY(float yaw)
 		{
 			rotationTransform = Matrix::CreateRotationY(yaw);
+			isTransformDirty = true;
 		}
 
 		void Scale(const Vector3& scale)
 		{
 			scaleTransform = Matrix::CreateScale(scale);
+			isTransformDirty = true;
 		}
 
 		void AppendTriangle(const Triangle& triangle, bool ignoreTransformUpdate = false)
 		{
+			std::vector<Vector3>& positions{ pData->positions };
 			int startIndex = static_cast<int>(positions.size());
 
 			positions.push_back(triangle.v0);
 			positions.push_back(triangle.v1);
 			positions.push_back(triangle.v2);
 
-			indices.push_back(startIndex);
-			indices.push_back(++startIndex);
-			indices.push_back(++startIndex);
+			pData->indices.push_back(startIndex);
+			pData->indices.push_back(++startIndex);
+			pData->indices.push_back(++startIndex);
 
-			normals.push_back(triangle.normal);
+			pData->normals.push_back(triangle.normal);
 
-			//Not ideal, but making sure all vertices are updated
+			//Not ideal, but making sure the BVH and the bounds are updated
 			if (!ignoreTransformUpdate)
+			{
+				UpdateAABB();
 				UpdateTransforms();
-
-			UpdateAABB();
+			}
 		}
 
 		void CalculateNormals()
 		{
-			//Triangles are saved as ID triplets
-			for (size_t tripletIndex{}; tripletIndex < indices.size(); tripletIndex+=3)
-			{
-				Vector3 a{ positions[indices[tripletIndex + 1]], positions[indices[tripletIndex]] };
-				Vector3 b{ positions[indices[tripletIndex + 2]], positions[indices[tripletIndex]]};
-
-				normals.push_back(Vector3::Cross(a, b).Normalized());
-			}
+			pData->CalculateNormals();
 		}
 
 		void UpdateTransforms()
 		{
-			transformedPositions.clear();
-			transformedNormals.clear();
+			//The world bounds also depend on the shared geometry, which another instance can have changed
+			if (!isTransformDirty && dataVersion == pData->version)
+				return;
+			isTransformDirty = false;
+			dataVersion = pData->version;
+			++transformVersion;
 
 			//Calculate Final Transform 
 			const auto finalTransform{ scaleTransform * rotationTransform * translationTransform };
 
-			//Transform Positions (positions > transformedPositions)
-			transformedPositions.reserve(positions.size());
-			for (const auto& position: positions)
-			{
-				transformedPositions.emplace_back(finalTransform.TransformPoint(position));
-			}
-
-			//Transform Normals (normals > transformedNormals)
-			transformedNormals.reserve(normals.size());
-			for (const auto& normal: normals)
-			{
-				transformedNormals.emplace_back(finalTransform.TransformVector(normal));
-			}
+			//Only the matrices change, positions and normals stay in object space
+			worldToObject = Matrix::Inverse(finalTransform);
+			normalToWorld = Matrix::Transpose(worldToObject);
 
 			//Update AABB
 			UpdateTransformedAABB(finalTransform);
-
 		}
 
+		//Call after changing the geometry, also updates the triangle blocks and fits the BVH to the new positions
 		void UpdateAABB()
 		{
-			if (not positions.empty())
-			{
-				minAABB = positions[0];
-				maxAABB = positions[0];
-				for (auto& p : positions)
-				{
-					minAABB = Vector3::Min(p, minAABB);
-					maxAABB = Vector3::Max(p, maxAABB);
-				}
-			}
+			pData->UpdateAABB();
+			pData->UpdateBVH();
+			pData->UpdateTriangleBlocks();
+
+			//Every instance sharing the data has outdated world bounds now
+			++pData->version;
 		}
 
 		void UpdateTransformedAABB(const Matrix& finalTransform)
 		{
+			const Vector3& minAABB{ pData->minAABB };
+			const Vector3& maxAABB{ pData->maxAABB };
+
 			// AABB update: be careful -> transform the 8 vertices of the aabb
 			// and calculate new min and max
 			Vector3 tMinAABB = finalTransform.TransformPoint(minAABB);
@@ -256,9 +420,53 @@ namespace dae
 		Vector3 origin{};
 		Vector3 normal{};
 		float t = FLT_MAX;
+		//Barycentric coordinates of a triangle hit (weights of v1 and v2), zero for spheres and planes
+		Vector2 barycentrics{};
 
 		bool didHit{ false };
 		unsigned char materialIndex{ 0 };
 	};
+
+	//Pyramid with its top at origin, spanned by 4 corner directions (in order around the pyramid)
+	//Everything inside has Dot(normal, point) + offset >= 0 for all 4 planes
+	struct Frustum final
+	{
+		Frustum() = default;
+		Frustum(const Vector3& _origin, const Vector3 (&cornerDirections)[4]) :
+			origin{ _origin }
+		{
+			const Vector3 centerDirection{ cornerDirections[0] + cornerDirections[1] + cornerDirections[2] + cornerDirections[3] };
+			for (int planeIndex{}; planeIndex < 4; ++planeIndex)
+			{
+				//Plane through two neighbouring corners, flipped to face the inside
+				//Corners that coincide (1 pixel wide packets) give a zero normal that never culls anything
+				Vector3 normal{ Vector3::Cross(cornerDirections[planeIndex], cornerDirections[(planeIndex + 1) % 4]) };
+				if (Vector3::Dot(normal, centerDirection) < 0.f)
+					normal = -normal;
+
+				normals[planeIndex] = normal;
+				offsets[planeIndex] = -Vector3::Dot(normal, origin);
+			}
+		}
+
+		Vector3 origin{};
+		Vector3 normals[4]{};
+		float offsets[4]{};
+	};
+
+	//Neighbouring primary rays (up to WIDTH x WIDTH pixels) that are traced together
+	//All rays start at the same origin and lie inside the frustum of the corner rays
+	struct RayPacket final
+	{
+		static constexpr uint32_t WIDTH{ 8 };
+		static constexpr uint32_t MAX_SIZE{ WIDTH * WIDTH };
+
+		Ray rays[MAX_SIZE]{};
+		uint32_t rayCount{};
+
+		//Directions of the corner rays, in order around the packet
+		Vector3 cornerDirections[4]{};
+		Frustum frustum{};
+	};
 #pragma endregion
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "Kernels.h"
+#include <array>
+#include <cmath>
+
+namespace dae
+{
+	namespace
+	{
+		std::array<uint8_t, SRGB_TABLE_SIZE> CreateSRGBTable()
+		{
+			std::array<uint8_t, SRGB_TABLE_SIZE> table{};
+			for (uint32_t index{}; index < SRGB_TABLE_SIZE; ++index)
+			{
+				const float linear{ static_cast<float>(index) / static_cast<float>(SRGB_TABLE_SIZE - 1) };
+				const float encoded{ linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.f / 2.4f) - 0.055f };
+				table[index] = static_cast<uint8_t>(encoded * 255.f + 0.5f);
+			}
+			return table;
+		}
+	}
+
+	//Built on first use, a dynamic initializer would run at startup before the CPU features are checked
+	const uint8_t* GetSRGBTable()
+	{
+		static const std::array<uint8_t, SRGB_TABLE_SIZE> table{ CreateSRGBTable() };
+		return table.data();
+	}
+
+	const Kernels& GetKernels(IsaLevel isaLevel)
+	{
+		switch (isaLevel)
+		{
+#if defined(SIMD_SSE)
+		case IsaLevel::AVX2:
+			return avx2::KERNELS;
+#endif
+		default:
+			return sse4::KERNELS;
+		}
+	}
+}
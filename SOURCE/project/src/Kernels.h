@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include "CpuFeatures.h"
+#include "RayStatistics.h"
+#include "SIMD.h"
+
+namespace dae
+{
+	//Forward Declarations
+	struct Ray;
+	struct RayPacket;
+	struct HitRecord;
+	struct SceneRenderView;
+	class Material;
+
+	//What the shading shows, the renderer compiles its scalar kernels and the SIMD kernels for every mode
+	enum class LightingMode
+	{
+		ObservedArea, //Lambert Cosine Law
+		Radiance, //Incident Radiance
+		BRDF, //Scattering of the light
+		Combined, //ObservedArea * Radiance * BRDF
+		Cost //Heatmap of the primitive and slab tests per pixel (primary and shadow rays), only with RAY_STATISTICS
+	};
+	constexpr uint32_t LIGHTING_MODE_COUNT{ RAY_STATISTICS_ENABLED ? 5u : 4u };
+
+	//8 bit sRGB encoded values for linear values in [0, 1], built on first use
+	constexpr uint32_t SRGB_TABLE_SIZE{ 4096 };
+	const uint8_t* GetSRGBTable();
+
+	//Surface points of up to SIMD::MAX_WIDTH pixels with the same material (SoA), unused lanes repeat the last point
+	struct SurfaceSamples final
+	{
+		float originX[SIMD::MAX_WIDTH], originY[SIMD::MAX_WIDTH], originZ[SIMD::MAX_WIDTH];
+		//Normalized direction from the point to the camera
+		float viewX[SIMD::MAX_WIDTH], viewY[SIMD::MAX_WIDTH], viewZ[SIMD::MAX_WIDTH];
+		float normalX[SIMD::MAX_WIDTH], normalY[SIMD::MAX_WIDTH], normalZ[SIMD::MAX_WIDTH];
+	};
+
+	//Shaded colors of SurfaceSamples, costs holds the tests of the shadow rays per sample in the Cost lighting mode
+	struct SampleColors final
+	{
+		float red[SIMD::MAX_WIDTH], green[SIMD::MAX_WIDTH], blue[SIMD::MAX_WIDTH];
+		uint32_t costs[SIMD::MAX_WIDTH];
+	};
+
+	//Linear colors at the render resolution (SoA), padded to a multiple of SIMD::MAX_WIDTH pixels
+	struct HDRImage final
+	{
+		const float* pRed;
+		const float* pGreen;
+		const float* pBlue;
+		uint32_t width, height;
+	};
+
+	//32 bit surface the tonemapped pixels are packed into
+	struct SurfaceImage final
+	{
+		uint32_t* pPixels;
+		uint32_t width, height;
+		//Pixels per row, rows can be padded
+		uint32_t rowStride;
+		uint32_t redShift, greenShift, blueShift, alphaMask;
+	};
+
+	//Shades the lights of a scene for one primary ray hit, black for a miss
+	using ShadeHitKernel = ColorRGB (*)(const SceneRenderView& view, const HitRecord& closestHit, const Vector3& rayDirection);
+	//Shades the lights of a scene for the samples [0, count)
+	using ShadeSamplesKernel = void (*)(const SceneRenderView& view, const Material& material, const SurfaceSamples& samples, uint32_t count, SampleColors& colors);
+	//Tonemaps (MaxToOne) the surface pixels [firstPixel, endPixel) and packs them, the HDR image is scaled up when it is smaller than the surface
+	using ToneMapKernel = void (*)(const HDRImage& hdrImage, float sampleWeight, const SurfaceImage& surfaceImage, uint32_t firstPixel, uint32_t endPixel);
+
+	/**
+	 * \brief The hot kernels of one instruction set level: intersection, BVH traversal, forward and deferred shading and tonemapping
+	 * Every level is compiled in its own translation unit and namespace (KernelsSSE4.cpp, KernelsAVX2.cpp),
+	 * only the code between SIMD_TARGET_BEGIN and SIMD_TARGET_END in Kernels.inl uses the wider instructions
+	 * Everything else is compiled once for the baseline, so the levels never share an inline function compiled for another cpu
+	 */
+	struct Kernels final
+	{
+		IsaLevel isaLevel;
+		//Samples pShadeSamples shades at once, SIMD::WIDTH of the level
+		uint32_t width;
+
+		void (*pGetClosestHit)(const SceneRenderView& view, const Ray& ray, HitRecord& closestHit);
+		//Closest hits of all rays of a packet, pClosestHits needs one HitRecord per ray
+		void (*pGetClosestHits)(const SceneRenderView& view, const RayPacket& packet, HitRecord* pClosestHits);
+		bool (*pIsOccluded)(const SceneRenderView& view, const Ray& ray);
+
+		//[lighting mode][shadows enabled]
+		ShadeHitKernel pShadeHit[LIGHTING_MODE_COUNT][2];
+		ShadeSamplesKernel pShadeSamples[LIGHTING_MODE_COUNT][2];
+		//[sRGB enabled][upscaled]
+		ToneMapKernel pToneMap[2][2];
+	};
+
+	namespace sse4
+	{
+		extern const Kernels KERNELS;
+	}
+#if defined(SIMD_SSE)
+	namespace avx2
+	{
+		extern const Kernels KERNELS;
+	}
+#endif
+
+	//Kernels of a level, the SSE4 ones when the level is not compiled in (no SSE)
+	const Kernels& GetKernels(IsaLevel isaLevel);
+}
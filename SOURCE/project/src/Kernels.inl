@@ -0,0 +1,1479 @@
+//Kernels of one instruction set level, included once per level (KernelsSSE4.cpp, KernelsAVX2.cpp) so no #pragma once
+//The includer defines:
+//  KERNEL_NAMESPACE  namespace of the level inside dae (sse4, avx2)
+//  KERNEL_ISA_LEVEL  IsaLevel of the level
+//  KERNEL_TARGETS    instruction sets the code is compiled for (SIMD_TARGETS_*)
+//  KERNEL_FLOAT      SIMD type of the level (Float4 or Float8)
+#if !defined(KERNEL_NAMESPACE) || !defined(KERNEL_ISA_LEVEL) || !defined(KERNEL_TARGETS) || !defined(KERNEL_FLOAT)
+	#error Define KERNEL_NAMESPACE, KERNEL_ISA_LEVEL, KERNEL_TARGETS and KERNEL_FLOAT before including Kernels.inl
+#endif
+
+//Everything shared is included before the target region, so it stays compiled for the baseline
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <span>
+#include <variant>
+#include "BRDFs.h"
+#include "DataTypes.h"
+#include "Kernels.h"
+#include "Material.h"
+#include "RayStatistics.h"
+#include "Scene.h"
+#include "SIMD.h"
+#include "Utils.h"
+
+SIMD_TARGET_BEGIN(KERNEL_TARGETS)
+namespace dae::KERNEL_NAMESPACE
+{
+	namespace SIMD
+	{
+		using namespace dae::SIMD;
+
+		//Widest type of the level
+		using FloatN = dae::SIMD::KERNEL_FLOAT;
+		constexpr uint32_t WIDTH{ sizeof(FloatN) / sizeof(float) };
+		static_assert(WIDTH <= MAX_WIDTH && PRIMITIVE_BLOCK_WIDTH % WIDTH == 0);
+
+		//Mask with the lanes set whose bit is set (inverse of MoveMask)
+		inline FloatN GetLaneMask(int bits)
+		{
+			float mask[WIDTH];
+			for (uint32_t lane{}; lane < WIDTH; ++lane) mask[lane] = std::bit_cast<float>((bits >> lane) & 1 ? 0xFFFFFFFFu : 0u);
+			return FloatN::Load(mask);
+		}
+
+		//For operations without a SIMD instruction (e.g. powf), applied lane by lane
+		template<typename Operation>
+		FloatN ApplyPerLane(FloatN a, Operation operation)
+		{
+			float values[WIDTH];
+			a.Store(values);
+			for (float& value : values) value = operation(value);
+			return FloatN::Load(values);
+		}
+
+#pragma region Vector3N
+		//WIDTH vectors in SoA form, per lane the results are the same as Vector3
+		//The operators are not friends, GCC does not apply the target pragma to friend functions defined in the class
+		struct Vector3N final
+		{
+			FloatN x, y, z;
+
+			static Vector3N Broadcast(const Vector3& v) { return { FloatN::Broadcast(v.x), FloatN::Broadcast(v.y), FloatN::Broadcast(v.z) }; }
+			static Vector3N Load(const float* pX, const float* pY, const float* pZ) { return { FloatN::Load(pX), FloatN::Load(pY), FloatN::Load(pZ) }; }
+
+			static FloatN Dot(const Vector3N& a, const Vector3N& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+			FloatN Magnitude() const { return FloatN::Sqrt(Dot(*this, *this)); }
+
+			FloatN Normalize()
+			{
+				const FloatN m{ Magnitude() };
+				x = x / m;
+				y = y / m;
+				z = z / m;
+				return m;
+			}
+
+			Vector3N Normalized() const
+			{
+				const FloatN m{ Magnitude() };
+				return { x / m, y / m, z / m };
+			}
+		};
+
+		inline Vector3N operator-(const Vector3N& v) { return { -v.x, -v.y, -v.z }; }
+		inline Vector3N operator+(const Vector3N& a, const Vector3N& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+		inline Vector3N operator-(const Vector3N& a, const Vector3N& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		inline Vector3N operator*(const Vector3N& v, FloatN scale) { return { v.x * scale, v.y * scale, v.z * scale }; }
+		inline Vector3N operator*(FloatN scale, const Vector3N& v) { return v * scale; }
+		inline Vector3N operator/(const Vector3N& v, FloatN scale) { return { v.x / scale, v.y / scale, v.z / scale }; }
+#pragma endregion
+#pragma region ColorN
+		//WIDTH colors in SoA form, per lane the results are the same as ColorRGB
+		struct ColorN final
+		{
+			FloatN r, g, b;
+
+			static ColorN Broadcast(const ColorRGB& c) { return { FloatN::Broadcast(c.r), FloatN::Broadcast(c.g), FloatN::Broadcast(c.b) }; }
+			static ColorN Select(FloatN mask, const ColorN& a, const ColorN& b)
+			{
+				return { FloatN::Select(mask, a.r, b.r), FloatN::Select(mask, a.g, b.g), FloatN::Select(mask, a.b, b.b) };
+			}
+
+			void MaxToOne()
+			{
+				const FloatN maxValue{ FloatN::Max(r, FloatN::Max(g, b)) };
+				const FloatN mask{ maxValue > FloatN::Broadcast(1.f) };
+				r = FloatN::Select(mask, r / maxValue, r);
+				g = FloatN::Select(mask, g / maxValue, g);
+				b = FloatN::Select(mask, b / maxValue, b);
+			}
+		};
+
+		inline ColorN operator+(const ColorN& a, const ColorN& c) { return { a.r + c.r, a.g + c.g, a.b + c.b }; }
+		inline ColorN operator-(const ColorN& a, const ColorN& c) { return { a.r - c.r, a.g - c.g, a.b - c.b }; }
+		inline ColorN operator*(const ColorN& a, const ColorN& c) { return { a.r * c.r, a.g * c.g, a.b * c.b }; }
+		inline ColorN operator*(const ColorN& c, FloatN s) { return { c.r * s, c.g * s, c.b * s }; }
+		inline ColorN operator/(const ColorN& c, FloatN s) { return { c.r / s, c.g / s, c.b / s }; }
+#pragma endregion
+	}
+
+	namespace GeometryUtils
+	{
+#pragma region Block Ray
+		//Ray broadcast to all lanes, prepared once per ray instead of once per block
+		struct BlockRay final
+		{
+			//cullSign is only used by triangle blocks (see GetCullSign)
+			explicit BlockRay(const Ray& ray, float cullSign = 0.f) :
+				originX{ SIMD::FloatN::Broadcast(ray.origin.x) }, originY{ SIMD::FloatN::Broadcast(ray.origin.y) }, originZ{ SIMD::FloatN::Broadcast(ray.origin.z) },
+				directionX{ SIMD::FloatN::Broadcast(ray.direction.x) }, directionY{ SIMD::FloatN::Broadcast(ray.direction.y) }, directionZ{ SIMD::FloatN::Broadcast(ray.direction.z) },
+				min{ SIMD::FloatN::Broadcast(ray.min) }, max{ SIMD::FloatN::Broadcast(ray.max) },
+				cullSign{ SIMD::FloatN::Broadcast(cullSign) }
+			{}
+
+			SIMD::FloatN originX, originY, originZ;
+			SIMD::FloatN directionX, directionY, directionZ;
+			SIMD::FloatN min, max;
+			SIMD::FloatN cullSign;
+		};
+
+		//Nearest lane of a hit mask, updates closestT and returns the lane when it is closer than closestT, -1 otherwise
+		inline int GetNearestLane(SIMD::FloatN hitMask, const SIMD::FloatN& t, float& closestT)
+		{
+			using SIMD::FloatN;
+
+			if (FloatN::MoveMask(hitMask) == 0)
+				return -1;
+
+			const FloatN hitT{ FloatN::Select(hitMask, t, FloatN::Broadcast(FLT_MAX)) };
+			const float nearestT{ FloatN::HorizontalMin(hitT) };
+			if (nearestT >= closestT)
+				return -1;
+
+			closestT = nearestT;
+			return SIMD::GetFirstSetLane(FloatN::MoveMask(hitT == FloatN::Broadcast(nearestT)));
+		}
+
+		//Nearest lane of a hit mask, updates closestT and closestIndex when it is closer than closestT
+		inline bool GetNearestLane(SIMD::FloatN hitMask, const SIMD::FloatN& t, const uint32_t* pIndices, float& closestT, uint32_t& closestIndex)
+		{
+			const int lane{ GetNearestLane(hitMask, t, closestT) };
+			if (lane < 0)
+				return false;
+
+			closestIndex = pIndices[lane];
+			return true;
+		}
+#pragma endregion
+#pragma region Sphere HitTest
+		/**
+		 * \brief Intersection of one ray with the SIMD::WIDTH spheres of a block from firstLane on (same math as the scalar HitTest_Sphere in Utils.h, direction must be normalized)
+		 * \return per lane mask of the spheres that are hit, t values of those lanes in t
+		 */
+		inline SIMD::FloatN HitTest_SphereBlock(const SphereBlock& block, uint32_t firstLane, const BlockRay& ray, SIMD::FloatN& t)
+		{
+			using SIMD::FloatN;
+
+			const FloatN toOriginX{ FloatN::Load(block.originX + firstLane) - ray.originX };
+			const FloatN toOriginY{ FloatN::Load(block.originY + firstLane) - ray.originY };
+			const FloatN toOriginZ{ FloatN::Load(block.originZ + firstLane) - ray.originZ };
+
+			const FloatN tAdjacent{ toOriginX * ray.directionX + toOriginY * ray.directionY + toOriginZ * ray.directionZ };
+			const FloatN oppositeSideSqrd{ toOriginX * toOriginX + toOriginY * toOriginY + toOriginZ * toOriginZ - tAdjacent * tAdjacent };
+			const FloatN tDeltaSqrd{ FloatN::Load(block.radiusSqrd + firstLane) - oppositeSideSqrd };
+
+			//Early out when the ray passes next to all spheres, no square roots needed
+			const FloatN zero{ FloatN::Broadcast(0.f) };
+			const FloatN discriminantMask{ tDeltaSqrd >= zero };
+			if (FloatN::MoveMask(discriminantMask) == 0)
+				return discriminantMask;
+
+			//Closest t in range, t1 when the ray starts inside the sphere
+			const FloatN tDelta{ FloatN::Sqrt(FloatN::Max(tDeltaSqrd, zero)) };
+			const FloatN t0{ tAdjacent - tDelta };
+			t = FloatN::Select(t0 > ray.min, t0, tAdjacent + tDelta);
+
+			return discriminantMask & (t > ray.min) & (t < ray.max);
+		}
+
+		//Closest hit in a block, updates closestT and closestSphere when a sphere is hit closer than closestT
+		inline bool HitTest_SphereBlock(const SphereBlock& block, const BlockRay& ray, float& closestT, uint32_t& closestSphere)
+		{
+			StatisticsUtils::CountPrimitiveTests(PRIMITIVE_BLOCK_WIDTH);
+
+			bool isHit{ false };
+			for (uint32_t firstLane{}; firstLane < PRIMITIVE_BLOCK_WIDTH; firstLane += SIMD::WIDTH)
+			{
+				SIMD::FloatN t;
+				const SIMD::FloatN hitMask{ HitTest_SphereBlock(block, firstLane, ray, t) };
+				isHit |= GetNearestLane(hitMask, t, block.sphereIndex + firstLane, closestT, closestSphere);
+			}
+			return isHit;
+		}
+
+		//Occlusion test, true when any sphere of the block is hit
+		inline bool HitTest_SphereBlock(const SphereBlock& block, const BlockRay& ray)
+		{
+			StatisticsUtils::CountPrimitiveTests(PRIMITIVE_BLOCK_WIDTH);
+
+			for (uint32_t firstLane{}; firstLane < PRIMITIVE_BLOCK_WIDTH; firstLane += SIMD::WIDTH)
+			{
+				SIMD::FloatN t;
+				if (SIMD::FloatN::MoveMask(HitTest_SphereBlock(block, firstLane, ray, t)) != 0)
+					return true;
+			}
+			return false;
+		}
+
+		//Fills in the hit information of a sphere that was found with the block tests
+		inline void SetSphereHitRecord(const Sphere& sphere, const Ray& ray, float t, HitRecord& hitRecord)
+		{
+			hitRecord.t = t;
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = sphere.materialIndex;
+			hitRecord.origin = ray.origin + ray.direction * t;
+			hitRecord.normal = (hitRecord.origin - sphere.origin).Normalized();
+			hitRecord.barycentrics = {};
+		}
+#pragma endregion
+#pragma region Plane HitTest
+		/**
+		 * \brief Intersection of one ray with the SIMD::WIDTH planes of a block from firstLane on
+		 * \return per lane mask of the planes that are hit, t values of those lanes in t
+		 */
+		inline SIMD::FloatN HitTest_PlaneBlock(const PlaneBlock& block, uint32_t firstLane, const BlockRay& ray, SIMD::FloatN& t)
+		{
+			using SIMD::FloatN;
+
+			const FloatN normalX{ FloatN::Load(block.normalX + firstLane) }, normalY{ FloatN::Load(block.normalY + firstLane) }, normalZ{ FloatN::Load(block.normalZ + firstLane) };
+			const FloatN originDotNormal{ ray.originX * normalX + ray.originY * normalY + ray.originZ * normalZ };
+			const FloatN directionDotNormal{ ray.directionX * normalX + ray.directionY * normalY + ray.directionZ * normalZ };
+			t = (FloatN::Load(block.distance + firstLane) - originDotNormal) / directionDotNormal;
+
+			return (t > ray.min) & (t < ray.max);
+		}
+
+		//Closest hit in a block, updates closestT and closestPlane when a plane is hit closer than closestT
+		inline bool HitTest_PlaneBlock(const PlaneBlock& block, const BlockRay& ray, float& closestT, uint32_t& closestPlane)
+		{
+			StatisticsUtils::CountPrimitiveTests(PRIMITIVE_BLOCK_WIDTH);
+
+			bool isHit{ false };
+			for (uint32_t firstLane{}; firstLane < PRIMITIVE_BLOCK_WIDTH; firstLane += SIMD::WIDTH)
+			{
+				SIMD::FloatN t;
+				const SIMD::FloatN hitMask{ HitTest_PlaneBlock(block, firstLane, ray, t) };
+				isHit |= GetNearestLane(hitMask, t, block.planeIndex + firstLane, closestT, closestPlane);
+			}
+			return isHit;
+		}
+
+		//Occlusion test, true when any plane of the block is hit
+		inline bool HitTest_PlaneBlock(const PlaneBlock& block, const BlockRay& ray)
+		{
+			StatisticsUtils::CountPrimitiveTests(PRIMITIVE_BLOCK_WIDTH);
+
+			for (uint32_t firstLane{}; firstLane < PRIMITIVE_BLOCK_WIDTH; firstLane += SIMD::WIDTH)
+			{
+				SIMD::FloatN t;
+				if (SIMD::FloatN::MoveMask(HitTest_PlaneBlock(block, firstLane, ray, t)) != 0)
+					return true;
+			}
+			return false;
+		}
+
+		//Fills in the hit information of a plane that was found with the block tests
+		inline void SetPlaneHitRecord(const Plane& plane, const Ray& ray, float t, HitRecord& hitRecord)
+		{
+			hitRecord.t = t;
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = plane.materialIndex;
+			hitRecord.origin = ray.origin + ray.direction * t;
+			hitRecord.normal = plane.normal;
+			hitRecord.barycentrics = {};
+		}
+#pragma endregion
+#pragma region TriangleMesh SlabTest
+		//Slab test to check if ray intersects with bounding box of mesh
+		inline bool SlabTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray)
+		{
+			StatisticsUtils::CountSlabTest();
+
+			const float tx1 = (mesh.transformedMinAABB.x - ray.origin.x) / ray.direction.x;
+			const float tx2 = (mesh.transformedMaxAABB.x - ray.origin.x) / ray.direction.x;
+
+			float tmin = std::min(tx1, tx2);
+			float tmax = std::max(tx1, tx2);
+
+			const float ty1 = (mesh.transformedMinAABB.y - ray.origin.y) / ray.direction.y;
+			const float ty2 = (mesh.transformedMaxAABB.y - ray.origin.y) / ray.direction.y;
+
+			tmin = std::max(tmin, std::min(ty1, ty2));
+			tmax = std::min(tmax, std::max(ty1, ty2));
+
+			const float tz1 = (mesh.transformedMinAABB.z - ray.origin.z) / ray.direction.z;
+			const float tz2 = (mesh.transformedMaxAABB.z - ray.origin.z) / ray.direction.z;
+
+			tmin = std::max(tmin, std::min(tz1, tz2));
+			tmax = std::min(tmax, std::max(tz1, tz2));
+
+			return tmax > 0 && tmax >= tmin;
+		}
+#pragma endregion
+#pragma region AABB SlabTest
+		//Slab test against a BVH node, returns the entry distance or FLT_MAX when the box is missed
+		//(or when the box is further away than maxDistance)
+		inline float SlabTest_AABB(const AABB& bounds, const Ray& ray, const Vector3& inverseDirection, float maxDistance)
+		{
+			StatisticsUtils::CountSlabTest();
+
+			const float tx1 = (bounds.min.x - ray.origin.x) * inverseDirection.x;
+			const float tx2 = (bounds.max.x - ray.origin.x) * inverseDirection.x;
+
+			float tmin = std::min(tx1, tx2);
+			float tmax = std::max(tx1, tx2);
+
+			const float ty1 = (bounds.min.y - ray.origin.y) * inverseDirection.y;
+			const float ty2 = (bounds.max.y - ray.origin.y) * inverseDirection.y;
+
+			tmin = std::max(tmin, std::min(ty1, ty2));
+			tmax = std::min(tmax, std::max(ty1, ty2));
+
+			const float tz1 = (bounds.min.z - ray.origin.z) * inverseDirection.z;
+			const float tz2 = (bounds.max.z - ray.origin.z) * inverseDirection.z;
+
+			tmin = std::max(tmin, std::min(tz1, tz2));
+			tmax = std::min(tmax, std::max(tz1, tz2));
+
+			if (tmax >= tmin && tmax > ray.min && tmin < maxDistance)
+				return tmin;
+			return FLT_MAX;
+		}
+#pragma endregion
+#pragma region Frustum Test
+		//Conservative test, false only when the box is completely outside one of the planes of the frustum
+		inline bool FrustumTest_AABB(const Frustum& frustum, const AABB& bounds)
+		{
+			for (int planeIndex{}; planeIndex < 4; ++planeIndex)
+			{
+				//Corner of the box that is the furthest along the normal of the plane
+				const Vector3& normal{ frustum.normals[planeIndex] };
+				const Vector3 corner
+				{
+					normal.x >= 0.f ? bounds.max.x : bounds.min.x,
+					normal.y >= 0.f ? bounds.max.y : bounds.min.y,
+					normal.z >= 0.f ? bounds.max.z : bounds.min.z
+				};
+
+				if (Vector3::Dot(normal, corner) + frustum.offsets[planeIndex] < 0.f)
+					return false;
+			}
+			return true;
+		}
+#pragma endregion
+#pragma region BVH Traversal
+		/**
+		 * \brief Front-to-back traversal of a BVH, the nearest child is visited first and the other one is pushed on the stack
+		 * \param bvh hierarchy to traverse
+		 * \param ray ray to traverse with
+		 * \param closestDistance distance of the closest hit so far, nodes further away are skipped (can be updated by testLeaf)
+		 * \param testLeaf called with every visited leaf node and its index, returning true stops the traversal
+		 */
+		template<typename LeafTest>
+		void TraverseBVHLeaves(const BVH& bvh, const Ray& ray, const float& closestDistance, LeafTest&& testLeaf)
+		{
+			if (bvh.IsEmpty()) return;
+
+			const std::vector<BVHNode>& nodes{ bvh.GetNodes() };
+			const Vector3 inverseDirection{ 1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z };
+
+			if (SlabTest_AABB(nodes[0].bounds, ray, inverseDirection, std::min(ray.max, closestDistance)) == FLT_MAX)
+				return;
+
+			uint32_t nodeStack[BVH_MAX_DEPTH];
+			float distanceStack[BVH_MAX_DEPTH];
+			uint32_t stackSize{};
+
+			//Pops the next node that can still contain a closer hit
+			const auto popNode = [&]() -> const BVHNode*
+			{
+				while (stackSize > 0)
+				{
+					--stackSize;
+					if (distanceStack[stackSize] < closestDistance)
+						return &nodes[nodeStack[stackSize]];
+				}
+				return nullptr;
+			};
+
+			const BVHNode* pNode{ &nodes[0] };
+			while (pNode)
+			{
+				if (pNode->IsLeaf())
+				{
+					if (testLeaf(*pNode, static_cast<uint32_t>(pNode - nodes.data())))
+						return;
+
+					pNode = popNode();
+					continue;
+				}
+
+				const float maxDistance{ std::min(ray.max, closestDistance) };
+				uint32_t nearIndex{ pNode->leftFirst };
+				uint32_t farIndex{ pNode->leftFirst + 1 };
+				float nearDistance{ SlabTest_AABB(nodes[nearIndex].bounds, ray, inverseDirection, maxDistance) };
+				float farDistance{ SlabTest_AABB(nodes[farIndex].bounds, ray, inverseDirection, maxDistance) };
+				if (nearDistance > farDistance)
+				{
+					std::swap(nearIndex, farIndex);
+					std::swap(nearDistance, farDistance);
+				}
+
+				if (nearDistance == FLT_MAX)
+				{
+					//Both children missed
+					pNode = popNode();
+					continue;
+				}
+
+				pNode = &nodes[nearIndex];
+				if (farDistance != FLT_MAX)
+				{
+					nodeStack[stackSize] = farIndex;
+					distanceStack[stackSize] = farDistance;
+					++stackSize;
+				}
+			}
+		}
+
+		/**
+		 * \brief Front-to-back traversal of a BVH for a whole ray packet
+		 * Nodes outside the frustum of the packet, or further away than maxDistance, are skipped for all rays at once
+		 * \param bvh hierarchy to traverse
+		 * \param frustum frustum that contains all rays of the packet
+		 * \param maxDistance no ray of the packet can hit anything further from the frustum origin (can be updated by testLeaf)
+		 * \param testLeaf called with every visited leaf node and its index, returning true stops the traversal
+		 */
+		template<typename LeafTest>
+		void TraverseBVHLeaves(const BVH& bvh, const Frustum& frustum, const float& maxDistance, LeafTest&& testLeaf)
+		{
+			if (bvh.IsEmpty()) return;
+
+			const std::vector<BVHNode>& nodes{ bvh.GetNodes() };
+
+			//Squared distance between the frustum origin and a node, FLT_MAX when the node can be skipped
+			const auto getNodeDistance = [&](const BVHNode& node)
+			{
+				const float sqrDistance{ node.bounds.GetSqrDistance(frustum.origin) };
+				if (sqrDistance >= Square(maxDistance) || !FrustumTest_AABB(frustum, node.bounds))
+					return FLT_MAX;
+				return sqrDistance;
+			};
+
+			if (getNodeDistance(nodes[0]) == FLT_MAX)
+				return;
+
+			uint32_t nodeStack[BVH_MAX_DEPTH];
+			float distanceStack[BVH_MAX_DEPTH];
+			uint32_t stackSize{};
+
+			//Pops the next node that can still contain a closer hit for one of the rays
+			const auto popNode = [&]() -> const BVHNode*
+			{
+				while (stackSize > 0)
+				{
+					--stackSize;
+					if (distanceStack[stackSize] < Square(maxDistance))
+						return &nodes[nodeStack[stackSize]];
+				}
+				return nullptr;
+			};
+
+			const BVHNode* pNode{ &nodes[0] };
+			while (pNode)
+			{
+				if (pNode->IsLeaf())
+				{
+					if (testLeaf(*pNode, static_cast<uint32_t>(pNode - nodes.data())))
+						return;
+
+					pNode = popNode();
+					continue;
+				}
+
+				uint32_t nearIndex{ pNode->leftFirst };
+				uint32_t farIndex{ pNode->leftFirst + 1 };
+				float nearDistance{ getNodeDistance(nodes[nearIndex]) };
+				float farDistance{ getNodeDistance(nodes[farIndex]) };
+				if (nearDistance > farDistance)
+				{
+					std::swap(nearIndex, farIndex);
+					std::swap(nearDistance, farDistance);
+				}
+
+				if (nearDistance == FLT_MAX)
+				{
+					//Both children culled
+					pNode = popNode();
+					continue;
+				}
+
+				pNode = &nodes[nearIndex];
+				if (farDistance != FLT_MAX)
+				{
+					nodeStack[stackSize] = farIndex;
+					distanceStack[stackSize] = farDistance;
+					++stackSize;
+				}
+			}
+		}
+
+		/**
+		 * \brief Same as TraverseBVHLeaves, but calls testPrimitive with the index of every primitive in a visited leaf
+		 * \param testPrimitive returning true stops the traversal
+		 */
+		template<typename PrimitiveTest>
+		void TraverseBVH(const BVH& bvh, const Ray& ray, const float& closestDistance, PrimitiveTest&& testPrimitive)
+		{
+			const std::vector<uint32_t>& primitiveIndices{ bvh.GetPrimitiveIndices() };
+			TraverseBVHLeaves(bvh, ray, closestDistance, [&](const BVHNode& leaf, uint32_t)
+			{
+				for (uint32_t index{}; index < leaf.primitiveCount; ++index)
+				{
+					if (testPrimitive(primitiveIndices[leaf.leftFirst + index]))
+						return true;
+				}
+				return false;
+			});
+		}
+
+		/**
+		 * \brief Calls testBlock for the primitive blocks (see BuildLeafBlocks) the ray can hit
+		 * Small BVHs test all their blocks, others only the blocks of the leaves the ray visits
+		 * \param blocks vector or span of the blocks
+		 * \param testBlock returning true stops the traversal
+		 */
+		template<typename Blocks, typename BlockTest>
+		void TraverseBVHBlocks(const BVH& bvh, const Blocks& blocks, std::span<const uint32_t> leafFirstBlock,
+			const Ray& ray, const float& closestDistance, BlockTest&& testBlock)
+		{
+			using Block = typename Blocks::value_type;
+			if (blocks.size() <= SMALL_BVH_BLOCK_COUNT)
+			{
+				for (const Block& block : blocks)
+				{
+					if (testBlock(block))
+						return;
+				}
+				return;
+			}
+
+			TraverseBVHLeaves(bvh, ray, closestDistance, [&](const BVHNode& leaf, uint32_t nodeIndex)
+			{
+				const uint32_t firstBlock{ leafFirstBlock[nodeIndex] };
+				const uint32_t blockCount{ (leaf.primitiveCount + PRIMITIVE_BLOCK_WIDTH - 1) / PRIMITIVE_BLOCK_WIDTH };
+				for (uint32_t blockIndex{ firstBlock }; blockIndex < firstBlock + blockCount; ++blockIndex)
+				{
+					if (testBlock(blocks[blockIndex]))
+						return true;
+				}
+				return false;
+			});
+		}
+
+		/**
+		 * \brief Packet version of TraverseBVHBlocks, subtrees are culled with the frustum of the packet and leaves are slab tested per ray
+		 * \param pRays rays of the packet (all inside frustum), directions do not have to be normalized
+		 * \param pClosestT closest hit per ray so far (can be updated by testBlocks)
+		 * \param testBlocks called as testBlocks(pBlocks, blockCount, rayIndex) for the blocks a ray can hit
+		 */
+		template<typename Blocks, typename BlockTest>
+		void TraverseBVHBlocks(const BVH& bvh, const Blocks& blocks, std::span<const uint32_t> leafFirstBlock,
+			const Frustum& frustum, const Ray* pRays, uint32_t rayCount, const float* pClosestT, BlockTest&& testBlocks)
+		{
+			using Block = typename Blocks::value_type;
+			if (blocks.size() <= SMALL_BVH_BLOCK_COUNT)
+			{
+				for (uint32_t rayIndex{}; rayIndex < rayCount; ++rayIndex)
+				{
+					testBlocks(blocks.data(), static_cast<uint32_t>(blocks.size()), rayIndex);
+				}
+				return;
+			}
+
+			//t values scale with the length of the direction, distances from the origin do not
+			float directionLengths[RayPacket::MAX_SIZE];
+			Vector3 inverseDirections[RayPacket::MAX_SIZE];
+			for (uint32_t rayIndex{}; rayIndex < rayCount; ++rayIndex)
+			{
+				const Vector3& direction{ pRays[rayIndex].direction };
+				directionLengths[rayIndex] = direction.Magnitude();
+				inverseDirections[rayIndex] = Vector3{ 1.f / direction.x, 1.f / direction.y, 1.f / direction.z };
+			}
+
+			const auto getMaxDistance = [&]()
+			{
+				float maxDistance{};
+				for (uint32_t rayIndex{}; rayIndex < rayCount; ++rayIndex)
+				{
+					maxDistance = std::max(maxDistance, std::min(pClosestT[rayIndex], pRays[rayIndex].max) * directionLengths[rayIndex]);
+				}
+				return maxDistance;
+			};
+
+			float maxDistance{ getMaxDistance() };
+			TraverseBVHLeaves(bvh, frustum, maxDistance, [&](const BVHNode& leaf, uint32_t nodeIndex)
+			{
+				const Block* pLeafBlocks{ &blocks[leafFirstBlock[nodeIndex]] };
+				const uint32_t blockCount{ (leaf.primitiveCount + PRIMITIVE_BLOCK_WIDTH - 1) / PRIMITIVE_BLOCK_WIDTH };
+				for (uint32_t rayIndex{}; rayIndex < rayCount; ++rayIndex)
+				{
+					const Ray& ray{ pRays[rayIndex] };
+					if (SlabTest_AABB(leaf.bounds, ray, inverseDirections[rayIndex], std::min(ray.max, pClosestT[rayIndex])) == FLT_MAX)
+						continue;
+
+					testBlocks(pLeafBlocks, blockCount, rayIndex);
+				}
+
+				maxDistance = getMaxDistance();
+				return false;
+			});
+		}
+#pragma endregion
+#pragma region TriangeMesh HitTest
+		//Sign the facing (normal dot direction) of a triangle must have to not be culled, 0 when nothing is culled
+		inline float GetCullSign(TriangleCullMode cullMode, bool isShadowRay)
+		{
+			float cullSign{};
+			switch (cullMode)
+			{
+			case TriangleCullMode::FrontFaceCulling:
+				cullSign = 1.f;
+				break;
+			case TriangleCullMode::BackFaceCulling:
+				cullSign = -1.f;
+				break;
+			case TriangleCullMode::NoCulling:
+				break;
+			}
+
+			//When performing shadow hittest, culling mode must be inverted
+			return isShadowRay ? -cullSign : cullSign;
+		}
+
+		/**
+		 * \brief Möller-Trumbore intersection of one ray with the SIMD::WIDTH triangles of a block from firstLane on
+		 * All conditions are combined without early outs, a parallel ray results in inf/nan values that fail the tests
+		 * \return per lane mask of the triangles that are hit, t values and barycentric coordinates (weights of v1 and v2) of those lanes in t, u and v
+		 */
+		inline SIMD::FloatN HitTest_TriangleBlock(const TriangleBlock& block, uint32_t firstLane, const BlockRay& ray, SIMD::FloatN& t, SIMD::FloatN& u, SIMD::FloatN& v)
+		{
+			using SIMD::FloatN;
+
+			const FloatN normalX{ FloatN::Load(block.normalX + firstLane) }, normalY{ FloatN::Load(block.normalY + firstLane) }, normalZ{ FloatN::Load(block.normalZ + firstLane) };
+			const FloatN normalDotDirection{ normalX * ray.directionX + normalY * ray.directionY + normalZ * ray.directionZ };
+
+			//pVector = Cross(direction, edge2)
+			const FloatN edge2X{ FloatN::Load(block.edge2X + firstLane) }, edge2Y{ FloatN::Load(block.edge2Y + firstLane) }, edge2Z{ FloatN::Load(block.edge2Z + firstLane) };
+			const FloatN pX{ ray.directionY * edge2Z - ray.directionZ * edge2Y };
+			const FloatN pY{ ray.directionZ * edge2X - ray.directionX * edge2Z };
+			const FloatN pZ{ ray.directionX * edge2Y - ray.directionY * edge2X };
+
+			const FloatN edge1X{ FloatN::Load(block.edge1X + firstLane) }, edge1Y{ FloatN::Load(block.edge1Y + firstLane) }, edge1Z{ FloatN::Load(block.edge1Z + firstLane) };
+			const FloatN inverseDeterminant{ FloatN::Broadcast(1.f) / (edge1X * pX + edge1Y * pY + edge1Z * pZ) };
+
+			const FloatN tX{ ray.originX - FloatN::Load(block.v0X + firstLane) };
+			const FloatN tY{ ray.originY - FloatN::Load(block.v0Y + firstLane) };
+			const FloatN tZ{ ray.originZ - FloatN::Load(block.v0Z + firstLane) };
+			u = (tX * pX + tY * pY + tZ * pZ) * inverseDeterminant;
+
+			//qVector = Cross(tVector, edge1)
+			const FloatN qX{ tY * edge1Z - tZ * edge1Y };
+			const FloatN qY{ tZ * edge1X - tX * edge1Z };
+			const FloatN qZ{ tX * edge1Y - tY * edge1X };
+			v = (ray.directionX * qX + ray.directionY * qY + ray.directionZ * qZ) * inverseDeterminant;
+			t = (edge2X * qX + edge2Y * qY + edge2Z * qZ) * inverseDeterminant;
+
+			const FloatN zero{ FloatN::Broadcast(0.f) };
+			return (normalDotDirection * ray.cullSign >= zero) & (FloatN::Abs(normalDotDirection) >= FloatN::Broadcast(FLT_EPSILON))
+				& (u >= zero) & (v >= zero) & (u + v <= FloatN::Broadcast(1.f))
+				& (t > ray.min) & (t < ray.max);
+		}
+
+		//Closest triangle hit of a mesh so far, the hit record is filled in from it once the traversal is done
+		struct TriangleBlockHit final
+		{
+			float t;
+			float u{}, v{};
+			const TriangleBlock* pBlock{ nullptr };
+			uint32_t lane{};
+		};
+
+		//Closest hit in a block, updates closestHit when a triangle is hit closer than closestHit.t
+		inline bool HitTest_TriangleBlock(const TriangleBlock& block, const BlockRay& ray, TriangleBlockHit& closestHit)
+		{
+			StatisticsUtils::CountPrimitiveTests(PRIMITIVE_BLOCK_WIDTH);
+
+			bool isHit{ false };
+			for (uint32_t firstLane{}; firstLane < PRIMITIVE_BLOCK_WIDTH; firstLane += SIMD::WIDTH)
+			{
+				SIMD::FloatN t, u, v;
+				const SIMD::FloatN hitMask{ HitTest_TriangleBlock(block, firstLane, ray, t, u, v) };
+				const int lane{ GetNearestLane(hitMask, t, closestHit.t) };
+				if (lane < 0)
+					continue;
+
+				float laneU[SIMD::WIDTH], laneV[SIMD::WIDTH];
+				u.Store(laneU);
+				v.Store(laneV);
+				closestHit.u = laneU[lane];
+				closestHit.v = laneV[lane];
+				closestHit.pBlock = &block;
+				closestHit.lane = firstLane + lane;
+				isHit = true;
+			}
+			return isHit;
+		}
+
+		//Occlusion test, true when any triangle of the block is hit
+		inline bool HitTest_TriangleBlock(const TriangleBlock& block, const BlockRay& ray)
+		{
+			StatisticsUtils::CountPrimitiveTests(PRIMITIVE_BLOCK_WIDTH);
+
+			for (uint32_t firstLane{}; firstLane < PRIMITIVE_BLOCK_WIDTH; firstLane += SIMD::WIDTH)
+			{
+				SIMD::FloatN t, u, v;
+				if (SIMD::FloatN::MoveMask(HitTest_TriangleBlock(block, firstLane, ray, t, u, v)) != 0)
+					return true;
+			}
+			return false;
+		}
+
+		//Moves a ray to the object space of a mesh
+		//The direction is not normalized, so t values stay the same in both spaces
+		inline Ray GetObjectSpaceRay(const TriangleMesh& mesh, const Ray& ray)
+		{
+			Ray objectRay{ ray };
+			objectRay.origin = mesh.worldToObject.TransformPoint(ray.origin);
+			objectRay.direction = mesh.worldToObject.TransformVector(ray.direction);
+			return objectRay;
+		}
+
+		//Fills in the hit information of the closest triangle of a mesh, in world space
+		inline void SetTriangleMeshHitRecord(const TriangleMesh& mesh, const Ray& ray, const Ray& objectRay, const TriangleBlockHit& hit, HitRecord& hitRecord)
+		{
+			//Flip normal when hitting a back facing triangle, so lighting is correct
+			const TriangleBlock& block{ *hit.pBlock };
+			Vector3 normal{ block.normalX[hit.lane], block.normalY[hit.lane], block.normalZ[hit.lane] };
+			if (Vector3::Dot(normal, objectRay.direction) > 0.f)
+				normal = -normal;
+
+			hitRecord.t = hit.t;
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = mesh.materialIndex;
+			hitRecord.origin = ray.origin + ray.direction * hit.t;
+			hitRecord.normal = mesh.normalToWorld.TransformVector(normal).Normalized();
+			hitRecord.barycentrics = { hit.u, hit.v };
+		}
+
+		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			//slabTest (world space)
+			if (!SlabTest_TriangleMesh(mesh, ray)) return false;
+
+			const Ray objectRay{ GetObjectSpaceRay(mesh, ray) };
+			const TriangleMeshData& meshData{ *mesh.pData };
+
+			//We assume 'ignoreHitRecord == true' means we are performing a shadow hittest
+			const BlockRay blockRay{ objectRay, GetCullSign(mesh.cullMode, ignoreHitRecord) };
+
+			//Only the closest triangle is tracked, hit information is calculated once at the end
+			TriangleBlockHit closestHit{ hitRecord.t };
+			TraverseBVHBlocks(meshData.bvh, meshData.triangleBlocks, meshData.leafFirstBlock, objectRay, closestHit.t, [&](const TriangleBlock& block)
+			{
+				HitTest_TriangleBlock(block, blockRay, closestHit);
+				return false;
+			});
+
+			if (closestHit.pBlock == nullptr)
+				return false;
+
+			if (not ignoreHitRecord)
+				SetTriangleMeshHitRecord(mesh, ray, objectRay, closestHit, hitRecord);
+			return true;
+		}
+
+		//Closest hits of a primary ray packet, the frustum of the packet culls the mesh and subtrees of its BVH for all rays at once
+		inline void HitTest_TriangleMesh(const TriangleMesh& mesh, const RayPacket& packet, HitRecord* pHitRecords)
+		{
+			if (!FrustumTest_AABB(packet.frustum, AABB{ mesh.transformedMinAABB, mesh.transformedMaxAABB }))
+				return;
+
+			const TriangleMeshData& meshData{ *mesh.pData };
+			const float cullSign{ GetCullSign(mesh.cullMode, false) };
+
+			//Object space packet, the frustum is rebuilt from the transformed corner rays
+			Ray objectRays[RayPacket::MAX_SIZE];
+			float closestT[RayPacket::MAX_SIZE];
+			TriangleBlockHit closestHits[RayPacket::MAX_SIZE];
+			for (uint32_t rayIndex{}; rayIndex < packet.rayCount; ++rayIndex)
+			{
+				objectRays[rayIndex] = GetObjectSpaceRay(mesh, packet.rays[rayIndex]);
+				closestT[rayIndex] = pHitRecords[rayIndex].t;
+				closestHits[rayIndex] = TriangleBlockHit{ pHitRecords[rayIndex].t };
+			}
+
+			Vector3 objectCornerDirections[4];
+			for (int cornerIndex{}; cornerIndex < 4; ++cornerIndex)
+			{
+				objectCornerDirections[cornerIndex] = mesh.worldToObject.TransformVector(packet.cornerDirections[cornerIndex]);
+			}
+			const Frustum objectFrustum{ mesh.worldToObject.TransformPoint(packet.frustum.origin), objectCornerDirections };
+
+			TraverseBVHBlocks(meshData.bvh, meshData.triangleBlocks, meshData.leafFirstBlock, objectFrustum, objectRays, packet.rayCount, closestT,
+				[&](const TriangleBlock* pBlocks, uint32_t blockCount, uint32_t rayIndex)
+				{
+					const BlockRay blockRay{ objectRays[rayIndex], cullSign };
+					for (uint32_t blockIndex{}; blockIndex < blockCount; ++blockIndex)
+					{
+						HitTest_TriangleBlock(pBlocks[blockIndex], blockRay, closestHits[rayIndex]);
+					}
+					//The traversal culls subtrees with the t values of closestT
+					closestT[rayIndex] = closestHits[rayIndex].t;
+				});
+
+			for (uint32_t rayIndex{}; rayIndex < packet.rayCount; ++rayIndex)
+			{
+				if (closestHits[rayIndex].pBlock != nullptr)
+					SetTriangleMeshHitRecord(mesh, packet.rays[rayIndex], objectRays[rayIndex], closestHits[rayIndex], pHitRecords[rayIndex]);
+			}
+		}
+
+		//Occlusion test, stops at the first triangle block that blocks the ray (no hit information)
+		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray)
+		{
+			if (!SlabTest_TriangleMesh(mesh, ray)) return false;
+
+			const Ray objectRay{ GetObjectSpaceRay(mesh, ray) };
+			const TriangleMeshData& meshData{ *mesh.pData };
+			const BlockRay blockRay{ objectRay, GetCullSign(mesh.cullMode, true) };
+
+			bool isHit{ false };
+			TraverseBVHBlocks(meshData.bvh, meshData.triangleBlocks, meshData.leafFirstBlock, objectRay, objectRay.max, [&](const TriangleBlock& block)
+			{
+				isHit = HitTest_TriangleBlock(block, blockRay);
+				return isHit;
+			});
+
+			return isHit;
+		}
+#pragma endregion
+
+	}
+
+	namespace LightUtils
+	{
+		using dae::LightUtils::GetDirectionToLight;
+		using dae::LightUtils::GetRadiance;
+
+		//Same as the scalar ones (Utils.h) for SIMD::WIDTH targets at once
+		inline SIMD::Vector3N GetDirectionToLight(const Light& light, const SIMD::Vector3N& origin)
+		{
+			switch (light.type)
+			{
+			case(LightType::Point):
+				return SIMD::Vector3N::Broadcast(light.origin) - origin;
+			case(LightType::Directional):
+				return -origin;
+			default:
+				return SIMD::Vector3N::Broadcast(Vector3{});
+			}
+		}
+
+		inline SIMD::ColorN GetRadiance(const Light& light, const SIMD::Vector3N& target)
+		{
+			switch (light.type)
+			{
+			case(LightType::Point):
+				{
+					const SIMD::FloatN radius{ (SIMD::Vector3N::Broadcast(light.origin) - target).Magnitude() };
+					return SIMD::ColorN::Broadcast(light.color * light.intensity) / (radius * radius);
+				}
+			case(LightType::Directional):
+				return SIMD::ColorN::Broadcast(light.color * light.intensity);
+			default:
+				return SIMD::ColorN::Broadcast(ColorRGB{});
+			}
+		}
+	}
+
+	namespace BRDF
+	{
+		using dae::BRDF::Lambert;
+		using dae::BRDF::Phong;
+		using dae::BRDF::FresnelFunction_Schlick;
+		using dae::BRDF::NormalDistribution_GGX;
+		using dae::BRDF::GeometryFunction_SchlickGGX;
+		using dae::BRDF::GeometryFunction_Smith;
+
+#pragma region Vectorized
+		//Same BRDFs for SIMD::WIDTH samples at once (SoA), used when shading pixels grouped by material
+		//Integer powers are multiplied out instead of calling powf
+		using SIMD::FloatN;
+		using SIMD::Vector3N;
+		using SIMD::ColorN;
+
+		static ColorN Phong(float ks, float exp, const Vector3N& l, const Vector3N& v, const Vector3N& n)
+		{
+			//light direction is inverted because Phong shading requires vector to point toward surface
+			const Vector3N reflect{ -l - FloatN::Broadcast(2.f) * Vector3N::Dot(-l, n) * n };
+			const FloatN cosAlfa{ FloatN::Max(Vector3N::Dot(reflect, v), FloatN::Broadcast(0.f)) };
+
+			//The exponent is a material parameter, so there is no fixed multiplication for it
+			const FloatN specularReflection{ FloatN::Broadcast(ks) * SIMD::ApplyPerLane(cosAlfa, [exp](float value) { return powf(value, exp); }) };
+			return { specularReflection, specularReflection, specularReflection };
+		}
+
+		static ColorN FresnelFunction_Schlick(const Vector3N& h, const Vector3N& v, const ColorRGB& f0)
+		{
+			const FloatN hDotv{ FloatN::Max(Vector3N::Dot(h, v), FloatN::Broadcast(0.f)) };
+			const FloatN x{ FloatN::Broadcast(1.f) - hDotv };
+			const FloatN xSqrd{ x * x };
+			constexpr ColorRGB one{ 1.f,1.f,1.f };
+			return ColorN::Broadcast(f0) + ColorN::Broadcast(one - f0) * (xSqrd * xSqrd * x);
+		}
+
+		static FloatN NormalDistribution_GGX(const Vector3N& n, const Vector3N& h, float roughness)
+		{
+			//Using UE definition for roughness, alpha is roughness squared
+			const float alpha{ Square(roughness) };
+			const FloatN alphaSqrd{ FloatN::Broadcast(Square(alpha)) };
+
+			//Calculate formula denominator
+			const FloatN nDoth{ FloatN::Max(Vector3N::Dot(n, h), FloatN::Broadcast(0.f)) };
+			const FloatN base{ nDoth * nDoth * (alphaSqrd - FloatN::Broadcast(1.f)) + FloatN::Broadcast(1.f) };
+			const FloatN denominator{ FloatN::Broadcast(PI) * (base * base) };
+
+			return alphaSqrd / denominator;
+		}
+
+		static FloatN GeometryFunction_SchlickGGX(const Vector3N& n, const Vector3N& v, float roughness)
+		{
+			//Using UE definition for roughness, alpha is roughness squared
+			const float alpha{ Square(roughness) };
+			const float k{ powf(alpha + 1, 2.f) / 8.f }; //Direct lighting
+
+			const FloatN nDotv{ FloatN::Max(Vector3N::Dot(n, v), FloatN::Broadcast(0.f)) };
+			const FloatN denominator{ nDotv * FloatN::Broadcast(1 - k) + FloatN::Broadcast(k) };
+
+			return nDotv / denominator;
+		}
+
+		static FloatN GeometryFunction_Smith(const Vector3N& n, const Vector3N& v, const Vector3N& l, float roughness)
+		{
+			return GeometryFunction_SchlickGGX(n, v, roughness) * GeometryFunction_SchlickGGX(n, l, roughness);
+		}
+#pragma endregion
+	}
+}
+
+namespace dae
+{
+	//SIMD shading of the materials for this level, see Material.h
+	template<>
+	struct MaterialKernels<KERNEL_ISA_LEVEL> final
+	{
+		using FloatN = KERNEL_NAMESPACE::SIMD::FloatN;
+		using Vector3N = KERNEL_NAMESPACE::SIMD::Vector3N;
+		using ColorN = KERNEL_NAMESPACE::SIMD::ColorN;
+
+		static ColorN Shade(const Material_SolidColor& material, const Vector3N&, const Vector3N&, const Vector3N&)
+		{
+			return ColorN::Broadcast(material.m_Color);
+		}
+
+		static ColorN Shade(const Material_Lambert& material, const Vector3N&, const Vector3N&, const Vector3N&)
+		{
+			return ColorN::Broadcast(BRDF::Lambert(material.m_DiffuseReflectance, material.m_DiffuseColor));
+		}
+
+		static ColorN Shade(const Material_LambertPhong& material, const Vector3N& n, const Vector3N& l, const Vector3N& v)
+		{
+			return ColorN::Broadcast(BRDF::Lambert(material.m_DiffuseReflectance, material.m_DiffuseColor))
+				+ KERNEL_NAMESPACE::BRDF::Phong(material.m_SpecularReflectance, material.m_PhongExponent, l, v, n);
+		}
+
+		static ColorN Shade(const Material_CookTorrence& material, const Vector3N& n, const Vector3N& l, const Vector3N& v)
+		{
+			//Base Reflectivity
+			ColorRGB f0{ material.m_Albedo };
+			if (material.m_Metalness <= 0.f)	f0 = { 0.04f, 0.04f, 0.04f };
+
+			// -- Calculate specular reflectance --
+			const Vector3N halfVector{ (v + l).Normalized() };
+
+			const ColorN F{ KERNEL_NAMESPACE::BRDF::FresnelFunction_Schlick(halfVector, v, f0) };
+			const FloatN D{ KERNEL_NAMESPACE::BRDF::NormalDistribution_GGX(n, halfVector, material.m_Roughness) };
+			const FloatN G{ KERNEL_NAMESPACE::BRDF::GeometryFunction_Smith(n, v, l, material.m_Roughness) };
+
+			//Calculate denominator
+			const FloatN vDotn{ Vector3N::Dot(v, n) };
+			const FloatN lDotn{ Vector3N::Dot(l, n) };
+			const FloatN denominator{ FloatN::Max(FloatN::Broadcast(4.f) * vDotn * lDotn, FloatN::Broadcast(0.0001f)) }; //Prevent division by zero
+
+			const ColorN specular{ F * D * G / denominator };
+
+			// -- Calculate diffuse reflectance --
+			if (material.m_Metalness > 0.f)
+				return specular;
+
+			const ColorN kd{ ColorN::Broadcast(ColorRGB{ 1.f,1.f,1.f }) - F };
+			const ColorN diffuse{ ColorN::Broadcast(material.m_Albedo) * kd / FloatN::Broadcast(PI) };
+
+			return diffuse + specular;
+		}
+
+		//SIMD::WIDTH samples at once, n is the surface normal of each sample
+		//Same dispatch as Material::Shade, without std::visit so the wide types never leave the kernels
+		static ColorN Shade(const Material& material, const Vector3N& n, const Vector3N& l, const Vector3N& v)
+		{
+			const auto& variant{ material.m_Material };
+			if (const Material_SolidColor* pSolidColor{ std::get_if<Material_SolidColor>(&variant) })
+				return Shade(*pSolidColor, n, l, v);
+			if (const Material_Lambert* pLambert{ std::get_if<Material_Lambert>(&variant) })
+				return Shade(*pLambert, n, l, v);
+			if (const Material_LambertPhong* pLambertPhong{ std::get_if<Material_LambertPhong>(&variant) })
+				return Shade(*pLambertPhong, n, l, v);
+			return Shade(std::get<Material_CookTorrence>(variant), n, l, v);
+		}
+	};
+}
+
+namespace dae::KERNEL_NAMESPACE
+{
+#pragma region Scene Queries
+	inline void GetClosestHit(const SceneRenderView& view, const Ray& ray, HitRecord& closestHit)
+	{
+		const GeometryUtils::BlockRay blockRay{ ray };
+
+		//Only the closest plane/sphere is tracked, hit information is calculated once at the end
+		float closestT{ closestHit.t };
+		uint32_t closestPlane{ UINT32_MAX };
+		uint32_t closestSphere{ UINT32_MAX };
+
+		for (const PlaneBlock& block : view.planeBlocks)
+		{
+			GeometryUtils::HitTest_PlaneBlock(block, blockRay, closestT, closestPlane);
+		}
+
+		GeometryUtils::TraverseBVHBlocks(*view.pSphereBVH, view.sphereBlocks, view.sphereLeafFirstBlock, ray, closestT, [&](const SphereBlock& block)
+		{
+			GeometryUtils::HitTest_SphereBlock(block, blockRay, closestT, closestSphere);
+			return false;
+		});
+
+		//Spheres are tested after the planes, so a sphere hit is always the closest one
+		if (closestSphere != UINT32_MAX)
+			GeometryUtils::SetSphereHitRecord(view.spheres[closestSphere], ray, closestT, closestHit);
+		else if (closestPlane != UINT32_MAX)
+			GeometryUtils::SetPlaneHitRecord(view.planes[closestPlane], ray, closestT, closestHit);
+
+		GeometryUtils::TraverseBVH(*view.pMeshBVH, ray, closestHit.t, [&](uint32_t meshIndex)
+		{
+			GeometryUtils::HitTest_TriangleMesh(view.triangleMeshes[meshIndex], ray, closestHit);
+			return false;
+		});
+	}
+
+	inline void GetClosestHits(const SceneRenderView& view, const RayPacket& packet, HitRecord* pClosestHits)
+	{
+		//Only the closest plane/sphere is tracked per ray, same as GetClosestHit
+		float closestT[RayPacket::MAX_SIZE];
+		uint32_t closestPlane[RayPacket::MAX_SIZE];
+		uint32_t closestSphere[RayPacket::MAX_SIZE];
+		for (uint32_t rayIndex{}; rayIndex < packet.rayCount; ++rayIndex)
+		{
+			closestT[rayIndex] = pClosestHits[rayIndex].t;
+			closestPlane[rayIndex] = UINT32_MAX;
+			closestSphere[rayIndex] = UINT32_MAX;
+
+			//Planes are infinite, nothing to cull
+			const GeometryUtils::BlockRay blockRay{ packet.rays[rayIndex] };
+			for (const PlaneBlock& block : view.planeBlocks)
+			{
+				GeometryUtils::HitTest_PlaneBlock(block, blockRay, closestT[rayIndex], closestPlane[rayIndex]);
+			}
+		}
+
+		GeometryUtils::TraverseBVHBlocks(*view.pSphereBVH, view.sphereBlocks, view.sphereLeafFirstBlock, packet.frustum, packet.rays, packet.rayCount, closestT,
+			[&](const SphereBlock* pBlocks, uint32_t blockCount, uint32_t rayIndex)
+			{
+				const GeometryUtils::BlockRay blockRay{ packet.rays[rayIndex] };
+				for (uint32_t blockIndex{}; blockIndex < blockCount; ++blockIndex)
+				{
+					GeometryUtils::HitTest_SphereBlock(pBlocks[blockIndex], blockRay, closestT[rayIndex], closestSphere[rayIndex]);
+				}
+			});
+
+		float maxDistance{};
+		for (uint32_t rayIndex{}; rayIndex < packet.rayCount; ++rayIndex)
+		{
+			const Ray& ray{ packet.rays[rayIndex] };
+			HitRecord& closestHit{ pClosestHits[rayIndex] };
+			if (closestSphere[rayIndex] != UINT32_MAX)
+				GeometryUtils::SetSphereHitRecord(view.spheres[closestSphere[rayIndex]], ray, closestT[rayIndex], closestHit);
+			else if (closestPlane[rayIndex] != UINT32_MAX)
+				GeometryUtils::SetPlaneHitRecord(view.planes[closestPlane[rayIndex]], ray, closestT[rayIndex], closestHit);
+
+			maxDistance = std::max(maxDistance, closestHit.t);
+		}
+
+		//Meshes outside the frustum, or behind the hits found so far, are skipped for the whole packet
+		const std::vector<uint32_t>& meshIndices{ view.pMeshBVH->GetPrimitiveIndices() };
+		GeometryUtils::TraverseBVHLeaves(*view.pMeshBVH, packet.frustum, maxDistance, [&](const BVHNode& leaf, uint32_t)
+		{
+			for (uint32_t index{}; index < leaf.primitiveCount; ++index)
+			{
+				GeometryUtils::HitTest_TriangleMesh(view.triangleMeshes[meshIndices[leaf.leftFirst + index]], packet, pClosestHits);
+			}
+
+			maxDistance = 0.f;
+			for (uint32_t rayIndex{}; rayIndex < packet.rayCount; ++rayIndex)
+			{
+				maxDistance = std::max(maxDistance, pClosestHits[rayIndex].t);
+			}
+			return false;
+		});
+	}
+
+	inline bool IsOccluded(const SceneRenderView& view, const Ray& ray)
+	{
+		const GeometryUtils::BlockRay blockRay{ ray };
+
+		for (const PlaneBlock& block : view.planeBlocks)
+		{
+			if (GeometryUtils::HitTest_PlaneBlock(block, blockRay))
+				return true;
+		}
+
+		//Any hit is enough, traversals stop as soon as something blocks the ray
+		bool isOccluded{ false };
+		GeometryUtils::TraverseBVHBlocks(*view.pSphereBVH, view.sphereBlocks, view.sphereLeafFirstBlock, ray, ray.max, [&](const SphereBlock& block)
+		{
+			isOccluded = GeometryUtils::HitTest_SphereBlock(block, blockRay);
+			return isOccluded;
+		});
+		if (isOccluded)
+			return true;
+
+		GeometryUtils::TraverseBVH(*view.pMeshBVH, ray, ray.max, [&](uint32_t meshIndex)
+		{
+			isOccluded = GeometryUtils::HitTest_TriangleMesh(view.triangleMeshes[meshIndex], ray);
+			return isOccluded;
+		});
+
+		return isOccluded;
+	}
+#pragma endregion
+
+#pragma region Shading
+	//Forward shading of one hit, see ShadeHitKernel
+	template<LightingMode lightingMode, bool shadowsEnabled>
+	ColorRGB ShadeHit(const SceneRenderView& view, const HitRecord& closestHit, const Vector3& rayDirection)
+	{
+		//Color to write to the color buffer (default = black)
+		ColorRGB finalColor{};
+		if (!closestHit.didHit)
+			return finalColor;
+
+		for (const Light& light : view.lights)
+		{
+			const Vector3 hitOrigin{ closestHit.origin };
+			Vector3 directionToLight{ LightUtils::GetDirectionToLight(light, hitOrigin) };
+			const float rayMax{ directionToLight.Normalize() };
+
+			//Only the terms the lighting mode shows are evaluated
+			constexpr bool useObservedArea{ lightingMode == LightingMode::ObservedArea || lightingMode == LightingMode::Combined || lightingMode == LightingMode::Cost };
+			float observedArea{};
+			if constexpr (useObservedArea)
+			{
+				//Lights behind the surface add nothing, so they don't need a shadow ray either
+				observedArea = Vector3::Dot(closestHit.normal, directionToLight);
+				if (observedArea <= 0.f)
+				{
+					if constexpr (shadowsEnabled)
+						StatisticsUtils::CountCulledShadowRays(1);
+					continue;
+				}
+			}
+
+			//The shadow ray is the most expensive part, so it is traced last
+			if constexpr (shadowsEnabled)
+			{
+				StatisticsUtils::CountShadowRay();
+				const Ray shadowRay{ hitOrigin, directionToLight, 0.001f, rayMax };
+				if (IsOccluded(view, shadowRay)) continue;
+			}
+
+			if constexpr (lightingMode == LightingMode::ObservedArea)
+			{
+				finalColor += {observedArea, observedArea, observedArea};
+			}
+			else if constexpr (lightingMode == LightingMode::Radiance)
+			{
+				finalColor += LightUtils::GetRadiance(light, closestHit.origin);
+			}
+			else if constexpr (lightingMode == LightingMode::BRDF)
+			{
+				finalColor += view.materials[closestHit.materialIndex].Shade(closestHit, directionToLight, -rayDirection); //invert rayDirection
+			}
+			else
+			{
+				const ColorRGB radiance{ LightUtils::GetRadiance(light, closestHit.origin) };
+				const ColorRGB BRDF{ view.materials[closestHit.materialIndex].Shade(closestHit, directionToLight, -rayDirection) }; //invert rayDirection
+				finalColor += radiance * BRDF * observedArea;
+			}
+		}
+		return finalColor;
+	}
+
+	//Deferred shading of SIMD::WIDTH samples with the same material at once, see ShadeSamplesKernel
+	template<LightingMode lightingMode, bool shadowsEnabled>
+	void ShadeSamples(const SceneRenderView& view, const Material& material, const SurfaceSamples& samples, uint32_t count, SampleColors& colors)
+	{
+		using SIMD::FloatN;
+		using SIMD::Vector3N;
+		using SIMD::ColorN;
+		constexpr uint32_t WIDTH{ SIMD::WIDTH };
+
+		const Vector3N hitOrigin{ Vector3N::Load(samples.originX, samples.originY, samples.originZ) };
+		const Vector3N viewDirection{ Vector3N::Load(samples.viewX, samples.viewY, samples.viewZ) };
+		const Vector3N normal{ Vector3N::Load(samples.normalX, samples.normalY, samples.normalZ) };
+
+		const int usedLanes{ (1 << count) - 1 };
+		const ColorN black{ ColorN::Broadcast(ColorRGB{}) };
+
+		ColorN finalColor{ black };
+		//Cost lighting mode: tests of the shadow rays per lane
+		[[maybe_unused]] uint32_t laneCosts[WIDTH]{};
+		for (const Light& light : view.lights)
+		{
+			Vector3N directionToLight{ LightUtils::GetDirectionToLight(light, hitOrigin) };
+			const FloatN rayMax{ directionToLight.Normalize() };
+			int litLanes{ usedLanes };
+
+			//Only the terms the lighting mode shows are evaluated
+			constexpr bool useObservedArea{ lightingMode == LightingMode::ObservedArea || lightingMode == LightingMode::Combined || lightingMode == LightingMode::Cost };
+			FloatN observedArea{};
+			if constexpr (useObservedArea)
+			{
+				//Lights behind the surface add nothing, so they don't need a shadow ray either
+				observedArea = Vector3N::Dot(normal, directionToLight);
+				litLanes &= FloatN::MoveMask(observedArea > FloatN::Broadcast(0.f));
+				if constexpr (shadowsEnabled)
+					StatisticsUtils::CountCulledShadowRays(std::popcount(static_cast<uint32_t>(usedLanes & ~litLanes)));
+				if (!litLanes) continue;
+			}
+
+			//Shadow rays are still traced one by one
+			if constexpr (shadowsEnabled)
+			{
+				float directionX[WIDTH], directionY[WIDTH], directionZ[WIDTH], rayMaxes[WIDTH];
+				directionToLight.x.Store(directionX);
+				directionToLight.y.Store(directionY);
+				directionToLight.z.Store(directionZ);
+				rayMax.Store(rayMaxes);
+
+				for (int lanes{ litLanes }; lanes != 0; lanes &= lanes - 1)
+				{
+					const int lane{ SIMD::GetFirstSetLane(lanes) };
+					const Ray shadowRay{ Vector3{ samples.originX[lane], samples.originY[lane], samples.originZ[lane] },
+						Vector3{ directionX[lane], directionY[lane], directionZ[lane] }, 0.001f, rayMaxes[lane] };
+					StatisticsUtils::CountShadowRay();
+					[[maybe_unused]] const uint64_t firstTestCount{ StatisticsUtils::GetThreadTestCount() };
+					if (IsOccluded(view, shadowRay))
+						litLanes &= ~(1 << lane);
+					if constexpr (lightingMode == LightingMode::Cost)
+						laneCosts[lane] += static_cast<uint32_t>(StatisticsUtils::GetThreadTestCount() - firstTestCount);
+				}
+				if (!litLanes) continue;
+			}
+
+			ColorN lightColor{};
+			if constexpr (lightingMode == LightingMode::ObservedArea)
+			{
+				lightColor = { observedArea, observedArea, observedArea };
+			}
+			else if constexpr (lightingMode == LightingMode::Radiance)
+			{
+				lightColor = LightUtils::GetRadiance(light, hitOrigin);
+			}
+			else if constexpr (lightingMode == LightingMode::BRDF)
+			{
+				lightColor = MaterialKernels<KERNEL_ISA_LEVEL>::Shade(material, normal, directionToLight, viewDirection);
+			}
+			else
+			{
+				const ColorN radiance{ LightUtils::GetRadiance(light, hitOrigin) };
+				const ColorN BRDF{ MaterialKernels<KERNEL_ISA_LEVEL>::Shade(material, normal, directionToLight, viewDirection) };
+				lightColor = radiance * BRDF * observedArea;
+			}
+			finalColor = finalColor + ColorN::Select(SIMD::GetLaneMask(litLanes), lightColor, black);
+		}
+
+		if constexpr (lightingMode == LightingMode::Cost)
+		{
+			std::copy(laneCosts, laneCosts + WIDTH, colors.costs);
+			return;
+		}
+
+		finalColor.r.Store(colors.red);
+		finalColor.g.Store(colors.green);
+		finalColor.b.Store(colors.blue);
+	}
+#pragma endregion
+
+#pragma region Tonemapping
+	//Bilinear samples of the HDR image for up to SIMD::WIDTH surface pixels starting at firstPixel
+	inline void SampleHDRImage(const HDRImage& hdrImage, const SurfaceImage& surfaceImage, uint32_t firstPixel, uint32_t count, float* pRed, float* pGreen, float* pBlue)
+	{
+		//Surface pixel centers mapped onto the render resolution
+		const float scaleX{ static_cast<float>(hdrImage.width) / static_cast<float>(surfaceImage.width) };
+		const float scaleY{ static_cast<float>(hdrImage.height) / static_cast<float>(surfaceImage.height) };
+		const float maxX{ static_cast<float>(hdrImage.width - 1) };
+		const float maxY{ static_cast<float>(hdrImage.height - 1) };
+
+		for (uint32_t lane{}; lane < count; ++lane)
+		{
+			const uint32_t pixelIndex{ firstPixel + lane };
+			const float x{ std::clamp((static_cast<float>(pixelIndex % surfaceImage.width) + 0.5f) * scaleX - 0.5f, 0.f, maxX) };
+			const float y{ std::clamp((static_cast<float>(pixelIndex / surfaceImage.width) + 0.5f) * scaleY - 0.5f, 0.f, maxY) };
+
+			const uint32_t x0{ static_cast<uint32_t>(x) };
+			const uint32_t y0{ static_cast<uint32_t>(y) };
+			const uint32_t x1{ std::min(x0 + 1, hdrImage.width - 1) };
+			const uint32_t y1{ std::min(y0 + 1, hdrImage.height - 1) };
+			const float fractionX{ x - static_cast<float>(x0) };
+			const float fractionY{ y - static_cast<float>(y0) };
+
+			const auto sample = [&](const float* pChannel)
+			{
+				const float top{ Lerpf(pChannel[x0 + y0 * hdrImage.width], pChannel[x1 + y0 * hdrImage.width], fractionX) };
+				const float bottom{ Lerpf(pChannel[x0 + y1 * hdrImage.width], pChannel[x1 + y1 * hdrImage.width], fractionX) };
+				return Lerpf(top, bottom, fractionY);
+			};
+			pRed[lane] = sample(hdrImage.pRed);
+			pGreen[lane] = sample(hdrImage.pGreen);
+			pBlue[lane] = sample(hdrImage.pBlue);
+		}
+	}
+
+	//See ToneMapKernel, compiled with and without sRGB and upscaling
+	template<bool sRGBEnabled, bool isUpscaled>
+	void ToneMap(const HDRImage& hdrImage, float sampleWeight, const SurfaceImage& surfaceImage, uint32_t firstPixel, uint32_t endPixel)
+	{
+		using SIMD::FloatN;
+		using SIMD::ColorN;
+		constexpr uint32_t WIDTH{ SIMD::WIDTH };
+
+		//Pixels are counted over the whole surface, the surface rows can be padded (pitch)
+		uint32_t x{ firstPixel % surfaceImage.width };
+		uint32_t* pRow{ surfaceImage.pPixels + firstPixel / surfaceImage.width * surfaceImage.rowStride };
+
+		//Without sRGB the channels are scaled to [0, 255], with sRGB to an index in the table
+		const FloatN scale{ FloatN::Broadcast(sRGBEnabled ? static_cast<float>(SRGB_TABLE_SIZE - 1) : 255.f) };
+		const FloatN rounding{ FloatN::Broadcast(sRGBEnabled ? 0.5f : 0.f) };
+		const FloatN zero{ FloatN::Broadcast(0.f) };
+		//Average of the accumulated samples
+		const FloatN weight{ FloatN::Broadcast(sampleWeight) };
+		const uint8_t* pSRGBTable{ GetSRGBTable() };
+
+		//The HDR image is padded, the last group only writes the pixels that exist
+		for (uint32_t first{ firstPixel }; first < endPixel; first += WIDTH)
+		{
+			const uint32_t count{ std::min(WIDTH, endPixel - first) };
+
+			ColorN color{};
+			if constexpr (isUpscaled)
+			{
+				float red[WIDTH]{}, green[WIDTH]{}, blue[WIDTH]{};
+				SampleHDRImage(hdrImage, surfaceImage, first, count, red, green, blue);
+				color = { FloatN::Load(red), FloatN::Load(green), FloatN::Load(blue) };
+			}
+			else
+			{
+				color = { FloatN::Load(hdrImage.pRed + first), FloatN::Load(hdrImage.pGreen + first), FloatN::Load(hdrImage.pBlue + first) };
+			}
+			color = color * weight;
+			color.MaxToOne();
+
+			int32_t red[WIDTH], green[WIDTH], blue[WIDTH];
+			(FloatN::Max(color.r, zero) * scale + rounding).StoreTruncated(red);
+			(FloatN::Max(color.g, zero) * scale + rounding).StoreTruncated(green);
+			(FloatN::Max(color.b, zero) * scale + rounding).StoreTruncated(blue);
+
+			for (uint32_t lane{}; lane < count; ++lane)
+			{
+				uint32_t r{ static_cast<uint32_t>(red[lane]) };
+				uint32_t g{ static_cast<uint32_t>(green[lane]) };
+				uint32_t b{ static_cast<uint32_t>(blue[lane]) };
+				if constexpr (sRGBEnabled)
+				{
+					r = pSRGBTable[r];
+					g = pSRGBTable[g];
+					b = pSRGBTable[b];
+				}
+				pRow[x] = (r << surfaceImage.redShift) | (g << surfaceImage.greenShift) | (b << surfaceImage.blueShift) | surfaceImage.alphaMask;
+				if (++x == surfaceImage.width)
+				{
+					x = 0;
+					pRow += surfaceImage.rowStride;
+				}
+			}
+		}
+	}
+#pragma endregion
+
+	//Instantiates every kernel of the level (the Cost kernels only with RAY_STATISTICS)
+	constexpr Kernels CreateKernels()
+	{
+		return Kernels
+		{
+			KERNEL_ISA_LEVEL,
+			SIMD::WIDTH,
+			&GetClosestHit,
+			&GetClosestHits,
+			&IsOccluded,
+			{
+				{ &ShadeHit<LightingMode::ObservedArea, false>, &ShadeHit<LightingMode::ObservedArea, true> },
+				{ &ShadeHit<LightingMode::Radiance, false>, &ShadeHit<LightingMode::Radiance, true> },
+				{ &ShadeHit<LightingMode::BRDF, false>, &ShadeHit<LightingMode::BRDF, true> },
+				{ &ShadeHit<LightingMode::Combined, false>, &ShadeHit<LightingMode::Combined, true> },
+#if defined(RAY_STATISTICS)
+				{ &ShadeHit<LightingMode::Cost, false>, &ShadeHit<LightingMode::Cost, true> },
+#endif
+			},
+			{
+				{ &ShadeSamples<LightingMode::ObservedArea, false>, &ShadeSamples<LightingMode::ObservedArea, true> },
+				{ &ShadeSamples<LightingMode::Radiance, false>, &ShadeSamples<LightingMode::Radiance, true> },
+				{ &ShadeSamples<LightingMode::BRDF, false>, &ShadeSamples<LightingMode::BRDF, true> },
+				{ &ShadeSamples<LightingMode::Combined, false>, &ShadeSamples<LightingMode::Combined, true> },
+#if defined(RAY_STATISTICS)
+				{ &ShadeSamples<LightingMode::Cost, false>, &ShadeSamples<LightingMode::Cost, true> },
+#endif
+			},
+			{
+				{ &ToneMap<false, false>, &ToneMap<false, true> },
+				{ &ToneMap<true, false>, &ToneMap<true, true> }
+			}
+		};
+	}
+}
+SIMD_TARGET_END
+
+#undef KERNEL_NAMESPACE
+#undef KERNEL_ISA_LEVEL
+#undef KERNEL_TARGETS
+#undef KERNEL_FLOAT
@@ -0,0 +1,15 @@
+//AVX2 level of the kernels (see Kernels.h)
+#include "Kernels.h"
+
+#if defined(SIMD_SSE)
+#define KERNEL_NAMESPACE avx2
+#define KERNEL_ISA_LEVEL IsaLevel::AVX2
+#define KERNEL_TARGETS SIMD_TARGETS_AVX2
+#define KERNEL_FLOAT Float8
+#include "Kernels.inl"
+
+namespace dae::avx2
+{
+	constinit const Kernels KERNELS{ CreateKernels() };
+}
+#endif
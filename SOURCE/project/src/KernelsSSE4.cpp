@@ -0,0 +1,13 @@
+//SSE4 level of the kernels, the baseline every other level falls back to (see Kernels.h)
+#include "Kernels.h"
+
+#define KERNEL_NAMESPACE sse4
+#define KERNEL_ISA_LEVEL IsaLevel::SSE4
+#define KERNEL_TARGETS SIMD_TARGETS_SSE4
+#define KERNEL_FLOAT Float4
+#include "Kernels.inl"
+
+namespace dae::sse4
+{
+	constinit const Kernels KERNELS{ CreateKernels() };
+}
@@ -2,46 +2,31 @@
 #include "Math.h"
 #include "DataTypes.h"
 #include "BRDFs.h"
+#include "CpuFeatures.h"
+#include <variant>
 
 namespace dae
 {
-#pragma region Material BASE
-	class Material
-	{
-	public:
-		Material() = default;
-		virtual ~Material() = default;
-
-		Material(const Material&) = delete;
-		Material(Material&&) noexcept = delete;
-		Material& operator=(const Material&) = delete;
-		Material& operator=(Material&&) noexcept = delete;
-
-		/**
-		 * \brief Function used to calculate the correct color for the specific material and its parameters
-		 * \param hitRecord current hitrecord
-		 * \param l light direction
-		 * \param v view direction
-		 * \return color
-		 */
-		virtual ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) = 0;
-	};
-#pragma endregion
+	//SIMD shading of the materials, specialized by the kernels of every instruction set level (Kernels.inl)
+	template<IsaLevel isaLevel>
+	struct MaterialKernels;
 
 #pragma region Material SOLID COLOR
 	//SOLID COLOR
 	//===========
-	class Material_SolidColor final : public Material
+	class Material_SolidColor final
 	{
 	public:
 		Material_SolidColor(const ColorRGB& color) : m_Color(color) {}
 
-		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v) override
+		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v) const
 		{
 			return m_Color;
 		}
 
 	private:
+		template<IsaLevel> friend struct MaterialKernels;
+
 		ColorRGB m_Color{ colors::White };
 	};
 #pragma endregion
@@ -49,18 +34,20 @@ namespace dae
 #pragma region Material LAMBERT
 	//LAMBERT
 	//=======
-	class Material_Lambert final : public Material
+	class Material_Lambert final
 	{
 	public:
 		Material_Lambert(const ColorRGB& diffuseColor, float diffuseReflectance) :
 			m_DiffuseColor(diffuseColor), m_DiffuseReflectance(diffuseReflectance) {}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v) const
 		{
 			return BRDF::Lambert(m_DiffuseReflectance, m_DiffuseColor);
 		}
 
 	private:
+		template<IsaLevel> friend struct MaterialKernels;
+
 		ColorRGB m_DiffuseColor{ colors::White };
 		float m_DiffuseReflectance{ 1.f }; //kd
 	};
@@ -69,20 +56,22 @@ namespace dae
 #pragma region Material LAMBERT PHONG
 	//LAMBERT-PHONG
 	//=============
-	class Material_LambertPhong final : public Material
+	class Material_LambertPhong final
 	{
 	public:
 		Material_LambertPhong(const ColorRGB& diffuseColor, float kd, float ks, float phongExponent) :
 			m_DiffuseColor(diffuseColor), m_DiffuseReflectance(kd), m_SpecularReflectance(ks),
 			m_PhongExponent(phongExponent) {}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v) const
 		{
 			return BRDF::Lambert(m_DiffuseReflectance, m_DiffuseColor)
 				+ BRDF::Phong(m_SpecularReflectance, m_PhongExponent, l, v, hitRecord.normal);
 		}
 
 	private:
+		template<IsaLevel> friend struct MaterialKernels;
+
 		ColorRGB m_DiffuseColor{ colors::White };
 		float m_DiffuseReflectance{ 0.5f }; //kd
 		float m_SpecularReflectance{ 0.5f }; //ks
@@ -92,13 +81,13 @@ namespace dae
 
 #pragma region Material COOK TORRENCE
 	//COOK TORRENCE
-	class Material_CookTorrence final : public Material
+	class Material_CookTorrence final
 	{
 	public:
 		Material_CookTorrence(const ColorRGB& albedo, float metalness, float roughness) :
 			m_Albedo(albedo), m_Metalness(metalness), m_Roughness(roughness) {}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v) const
 		{
 			//Base Reflectivity
 			ColorRGB f0{m_Albedo};
@@ -133,9 +122,39 @@ namespace dae
 		}
 
 	private:
+		template<IsaLevel> friend struct MaterialKernels;
+
 		ColorRGB m_Albedo{ 0.955f, 0.637f, 0.538f }; //Copper
 		float m_Metalness{ 1.0f };
 		float m_Roughness{ 0.1f }; // [1.0 > 0.0] >> [ROUGH > SMOOTH]
 	};
 #pragma endregion
+
+#pragma region Material
+	//Closed set of materials, stored by value so a scene keeps all of them in one contiguous table
+	//Shade dispatches with a switch on the type instead of a virtual call, the BRDF math can be inlined
+	class Material final
+	{
+	public:
+		template<typename MaterialType>
+		Material(const MaterialType& material) : m_Material(material) {}
+
+		/**
+		 * \brief Function used to calculate the correct color for the specific material and its parameters
+		 * \param hitRecord current hitrecord
+		 * \param l light direction
+		 * \param v view direction
+		 * \return color
+		 */
+		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) const
+		{
+			return std::visit([&](const auto& material) { return material.Shade(hitRecord, l, v); }, m_Material);
+		}
+
+	private:
+		template<IsaLevel> friend struct MaterialKernels;
+
+		std::variant<Material_SolidColor, Material_Lambert, Material_LambertPhong, Material_CookTorrence> m_Material;
+	};
+#pragma endregion
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include <cassert>
+#include "SIMDConfig.h"
 #include "Vector3.h"
 #include "Vector4.h"
 
@@ -71,5 +73,93 @@ namespace dae {
 		// v1x v1y v1z v1w
 		// v2x v2y v2z v2w
 		// v3x v3y v3z v3w
+
+#if defined(SIMD_SSE)
+		//A row is 4 floats, a transform is the sum of the rows scaled by the components
+		__m128 LoadRow(int index) const { return _mm_loadu_ps(&data[index].x); }
+		static __m128 TransformRows(__m128 row0, __m128 row1, __m128 row2, float x, float y, float z)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(row0, _mm_set1_ps(x)), _mm_mul_ps(row1, _mm_set1_ps(y))), _mm_mul_ps(row2, _mm_set1_ps(z)));
+		}
+		static Vector3 ToVector3(__m128 value)
+		{
+			float components[4];
+			_mm_storeu_ps(components, value);
+			return Vector3{ components[0], components[1], components[2] };
+		}
+#endif
 	};
+
+	//Transforms are defined here so the per vertex and per ray loops can inline them
+	inline Matrix::Matrix(const Matrix& m)
+	{
+		data[0] = m[0];
+		data[1] = m[1];
+		data[2] = m[2];
+		data[3] = m[3];
+	}
+
+	inline Vector3 Matrix::TransformVector(const Vector3& v) const
+	{
+		return TransformVector(v.x, v.y, v.z);
+	}
+
+	inline Vector3 Matrix::TransformVector(float x, float y, float z) const
+	{
+#if defined(SIMD_SSE)
+		return ToVector3(TransformRows(LoadRow(0), LoadRow(1), LoadRow(2), x, y, z));
+#else
+		return Vector3{
+			data[0].x * x + data[1].x * y + data[2].x * z,
+			data[0].y * x + data[1].y * y + data[2].y * z,
+			data[0].z * x + data[1].z * y + data[2].z * z
+		};
+#endif
+	}
+
+	inline Vector3 Matrix::TransformPoint(const Vector3& p) const
+	{
+		return TransformPoint(p.x, p.y, p.z);
+	}
+
+	inline Vector3 Matrix::TransformPoint(float x, float y, float z) const
+	{
+#if defined(SIMD_SSE)
+		return ToVector3(_mm_add_ps(TransformRows(LoadRow(0), LoadRow(1), LoadRow(2), x, y, z), LoadRow(3)));
+#else
+		return Vector3{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
+		};
+#endif
+	}
+
+	inline Vector4 Matrix::TransformPoint(const Vector4& p) const
+	{
+		return TransformPoint(p.x, p.y, p.z, p.w);
+	}
+
+	//w is assumed to be 1, the translation is always added
+	inline Vector4 Matrix::TransformPoint(float x, float y, float z, [[maybe_unused]] float w) const
+	{
+		return Vector4{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
+			data[0].w * x + data[1].w * y + data[2].w * z + data[3].w
+		};
+	}
+
+	inline Vector4& Matrix::operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	inline Vector4 Matrix::operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "RayStatistics.h"
+#include <mutex>
+#include <vector>
+
+namespace dae
+{
+#if defined(RAY_STATISTICS)
+	namespace
+	{
+		//Counters of the living threads, and what the threads that already ended counted since the last collect
+		struct StatisticsRegistry final
+		{
+			std::mutex mutex{};
+			std::vector<RayStatistics*> threadStatistics{};
+			RayStatistics endedThreads{};
+		};
+
+		StatisticsRegistry& GetRegistry()
+		{
+			static StatisticsRegistry registry{};
+			return registry;
+		}
+	}
+
+	ThreadRayStatistics::ThreadRayStatistics()
+	{
+		StatisticsRegistry& registry{ GetRegistry() };
+		const std::lock_guard lock{ registry.mutex };
+		registry.threadStatistics.push_back(&statistics);
+	}
+
+	ThreadRayStatistics::~ThreadRayStatistics()
+	{
+		//Threads end when the thread count changes, their counts still belong to the current frame
+		StatisticsRegistry& registry{ GetRegistry() };
+		const std::lock_guard lock{ registry.mutex };
+		registry.endedThreads += statistics;
+		std::erase(registry.threadStatistics, &statistics);
+	}
+#endif
+
+	RayStatistics StatisticsUtils::CollectRayStatistics()
+	{
+		RayStatistics result{};
+#if defined(RAY_STATISTICS)
+		StatisticsRegistry& registry{ GetRegistry() };
+		const std::lock_guard lock{ registry.mutex };
+		result = registry.endedThreads;
+		registry.endedThreads = {};
+		for (RayStatistics* pStatistics : registry.threadStatistics)
+		{
+			result += *pStatistics;
+			*pStatistics = {};
+		}
+#endif
+		return result;
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	//Traversal counters are only compiled in with RAY_STATISTICS (RAY_STATISTICS_ENABLED in CMakeLists.txt)
+	//Without it the Count functions are empty, so the traversal code has no extra work
+#if defined(RAY_STATISTICS)
+	constexpr bool RAY_STATISTICS_ENABLED{ true };
+#else
+	constexpr bool RAY_STATISTICS_ENABLED{ false };
+#endif
+
+	//Work done for the rays of a frame
+	struct RayStatistics final
+	{
+		uint64_t primaryRays{};
+		//Primitives tested with the block tests, a block counts as PRIMITIVE_BLOCK_WIDTH primitives
+		uint64_t primitiveTests{};
+		//Ray - box tests of BVH nodes and meshes, packet frustum tests are not counted
+		uint64_t slabTests{};
+		uint64_t shadowRaysCast{};
+		//Shadow rays that were not needed because the light is behind the surface
+		uint64_t shadowRaysCulled{};
+
+		RayStatistics& operator+=(const RayStatistics& other)
+		{
+			primaryRays += other.primaryRays;
+			primitiveTests += other.primitiveTests;
+			slabTests += other.slabTests;
+			shadowRaysCast += other.shadowRaysCast;
+			shadowRaysCulled += other.shadowRaysCulled;
+			return *this;
+		}
+
+		uint64_t GetRayCount() const { return primaryRays + shadowRaysCast; }
+		uint64_t GetTestCount() const { return primitiveTests + slabTests; }
+		//Primitive and slab tests per traced ray (primary and shadow)
+		float GetTestsPerRay() const
+		{
+			const uint64_t rayCount{ GetRayCount() };
+			return rayCount > 0 ? static_cast<float>(GetTestCount()) / static_cast<float>(rayCount) : 0.f;
+		}
+	};
+
+#if defined(RAY_STATISTICS)
+	//Counters of one thread, registered while the thread lives so CollectRayStatistics can find them
+	struct ThreadRayStatistics final
+	{
+		ThreadRayStatistics();
+		~ThreadRayStatistics();
+
+		ThreadRayStatistics(const ThreadRayStatistics&) = delete;
+		ThreadRayStatistics(ThreadRayStatistics&&) noexcept = delete;
+		ThreadRayStatistics& operator=(const ThreadRayStatistics&) = delete;
+		ThreadRayStatistics& operator=(ThreadRayStatistics&&) noexcept = delete;
+
+		RayStatistics statistics{};
+	};
+	inline thread_local ThreadRayStatistics g_ThreadRayStatistics{};
+#endif
+
+	namespace StatisticsUtils
+	{
+		inline void CountPrimitiveTests(uint32_t count)
+		{
+#if defined(RAY_STATISTICS)
+			g_ThreadRayStatistics.statistics.primitiveTests += count;
+#else
+			(void)count;
+#endif
+		}
+
+		inline void CountSlabTest()
+		{
+#if defined(RAY_STATISTICS)
+			++g_ThreadRayStatistics.statistics.slabTests;
+#endif
+		}
+
+		inline void CountShadowRay()
+		{
+#if defined(RAY_STATISTICS)
+			++g_ThreadRayStatistics.statistics.shadowRaysCast;
+#endif
+		}
+
+		inline void CountCulledShadowRays(uint32_t count)
+		{
+#if defined(RAY_STATISTICS)
+			g_ThreadRayStatistics.statistics.shadowRaysCulled += count;
+#else
+			(void)count;
+#endif
+		}
+
+		//Primitive and slab tests of the calling thread so far, the difference of two calls is the cost of the work in between
+		inline uint64_t GetThreadTestCount()
+		{
+#if defined(RAY_STATISTICS)
+			return g_ThreadRayStatistics.statistics.GetTestCount();
+#else
+			return 0;
+#endif
+		}
+
+		//Sum of the counters of all threads since the previous call, the counters start again from 0
+		//Only call it while no other thread is tracing rays (e.g. between two frames)
+		RayStatistics CollectRayStatistics();
+	}
+}
@@ -0,0 +1,78 @@
+#include "RenderScaleController.h"
+#include <algorithm>
+#include <cmath>
+
+namespace dae
+{
+	RenderScaleController::RenderScaleController(float targetFrameTime, float minScale, float maxScale) :
+		m_TargetFrameTime{ targetFrameTime },
+		m_MinScale{ std::min(minScale, maxScale) },
+		m_MaxScale{ maxScale },
+		m_Scale{ maxScale }
+	{
+	}
+
+	void RenderScaleController::Update(float frameTime)
+	{
+		m_FrameTimes[m_FrameCount % HISTORY_SIZE] = frameTime;
+		++m_FrameCount;
+		++m_FramesSinceChange;
+
+		if (m_FramesSinceChange < SETTLE_FRAMES)
+			return;
+
+		//Only the frames rendered at the current scale tell how expensive it is
+		const uint32_t frameCount{ std::min(m_FramesSinceChange - 1, HISTORY_SIZE) };
+		float totalFrameTime{};
+		for (uint32_t index{ GetFrameTimeCount() - frameCount }; index < GetFrameTimeCount(); ++index)
+		{
+			totalFrameTime += GetFrameTime(index);
+		}
+		const float averageFrameTime{ totalFrameTime / static_cast<float>(frameCount) };
+
+		const float ratio{ m_TargetFrameTime / std::max(averageFrameTime, 1e-6f) };
+		if (std::abs(ratio - 1.f) < TOLERANCE)
+			return;
+
+		const float step{ std::clamp(std::sqrt(ratio), 1.f / MAX_STEP, MAX_STEP) };
+		const float scale{ std::clamp(std::round(m_Scale * step * SCALE_STEPS) / SCALE_STEPS, m_MinScale, m_MaxScale) };
+		if (scale == m_Scale)
+			return;
+
+		m_Scale = scale;
+		m_FramesSinceChange = 0;
+	}
+
+	void RenderScaleController::Reset()
+	{
+		m_Scale = m_MaxScale;
+		m_FrameCount = 0;
+		m_FramesSinceChange = 0;
+	}
+
+	uint32_t RenderScaleController::GetFrameTimeCount() const
+	{
+		return std::min(m_FrameCount, HISTORY_SIZE);
+	}
+
+	float RenderScaleController::GetFrameTime(uint32_t index) const
+	{
+		//Once the history is full, the oldest frame time is the one that gets overwritten next
+		const uint32_t oldest{ m_FrameCount < HISTORY_SIZE ? 0 : m_FrameCount % HISTORY_SIZE };
+		return m_FrameTimes[(oldest + index) % HISTORY_SIZE];
+	}
+
+	float RenderScaleController::GetAverageFrameTime() const
+	{
+		const uint32_t frameCount{ GetFrameTimeCount() };
+		if (frameCount == 0)
+			return 0.f;
+
+		float totalFrameTime{};
+		for (uint32_t index{}; index < frameCount; ++index)
+		{
+			totalFrameTime += GetFrameTime(index);
+		}
+		return totalFrameTime / static_cast<float>(frameCount);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace dae
+{
+	//Picks the render resolution (as a fraction of the window resolution, per axis) that keeps the frame time close to a target
+	//Render cost follows the pixel count, so the scale moves with the square root of target / measured frame time
+	class RenderScaleController final
+	{
+	public:
+		static constexpr uint32_t HISTORY_SIZE{ 16 };
+
+		//targetFrameTime in seconds, the scale stays in [minScale, maxScale]
+		explicit RenderScaleController(float targetFrameTime = 1.f / 60.f, float minScale = 0.5f, float maxScale = 1.f);
+		~RenderScaleController() = default;
+
+		RenderScaleController(const RenderScaleController&) = delete;
+		RenderScaleController(RenderScaleController&&) noexcept = delete;
+		RenderScaleController& operator=(const RenderScaleController&) = delete;
+		RenderScaleController& operator=(RenderScaleController&&) noexcept = delete;
+
+		//Call once per frame with the time the frame took (Timer::GetElapsed)
+		void Update(float frameTime);
+		void Reset();
+
+		float GetScale() const { return m_Scale; }
+		float GetTargetFrameTime() const { return m_TargetFrameTime; }
+
+		//Frame times of the last GetFrameTimeCount() frames, index 0 is the oldest
+		uint32_t GetFrameTimeCount() const;
+		float GetFrameTime(uint32_t index) const;
+		float GetAverageFrameTime() const;
+
+	private:
+		//Frames measured after a scale change before the next change, the first frame redraws everything
+		static constexpr uint32_t SETTLE_FRAMES{ 4 };
+		//No change while the frame time is this close to the target
+		static constexpr float TOLERANCE{ 0.1f };
+		//Largest change of the scale at once
+		static constexpr float MAX_STEP{ 1.25f };
+		//The scale is rounded to steps of 1 / SCALE_STEPS
+		static constexpr float SCALE_STEPS{ 32.f };
+
+		float m_TargetFrameTime;
+		float m_MinScale;
+		float m_MaxScale;
+		float m_Scale;
+
+		std::array<float, HISTORY_SIZE> m_FrameTimes{};
+		uint32_t m_FrameCount{};
+		uint32_t m_FramesSinceChange{};
+	};
+}
@@ -8,137 +8,954 @@
 #include "Matrix.h"
 #include "Material.h"
 #include "Scene.h"
+#include "SIMD.h"
 #include "Utils.h"
 
-#include <execution>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <fstream>
+#include <iostream>
 #define PARALLEL_EXECUTION
 
 using namespace dae;
 
+//Hit pixels handed to a thread at once in the shading pass of deferred shading
+constexpr uint32_t SHADE_CHUNK_SIZE{ 1024 };
+//Pixels tonemapped and packed by a thread at once, multiple of SIMD::MAX_WIDTH
+constexpr uint32_t PACK_CHUNK_SIZE{ 4096 };
+//Edge pixels supersampled by a thread at once in adaptive anti-aliasing
+constexpr uint32_t SUPERSAMPLE_CHUNK_SIZE{ 64 };
+
+//Adaptive anti-aliasing: a neighbour with another material always makes an edge, normals and brightness have to differ more than this
+constexpr float EDGE_NORMAL_THRESHOLD{ 0.05f }; //1 - cos(angle), about 18 degrees
+constexpr float EDGE_LUMINANCE_THRESHOLD{ 0.1f };
+//Edge pixels get n x n stratified samples
+constexpr uint32_t MIN_SAMPLES_PER_AXIS{ 2 };
+constexpr uint32_t MAX_SAMPLES_PER_AXIS{ 4 };
+//Cost lighting mode: pixels with this many tests or more are fully red
+constexpr float HEATMAP_MAX_COST{ 2048.f };
+
+namespace
+{
+	//Halton sequence, spreads the progressive samples evenly over the pixel
+	float GetRadicalInverse(uint32_t index, uint32_t base)
+	{
+		const float inverseBase{ 1.f / static_cast<float>(base) };
+		float fraction{ inverseBase };
+		float result{};
+		while (index > 0)
+		{
+			result += static_cast<float>(index % base) * fraction;
+			index /= base;
+			fraction *= inverseBase;
+		}
+		return result;
+	}
+
+	//Luminance of the color as it is displayed, after MaxToOne
+	float GetDisplayedLuminance(float red, float green, float blue)
+	{
+		const float maxValue{ std::max({ red, green, blue, 1.f }) };
+		return (0.2126f * red + 0.7152f * green + 0.0722f * blue) / maxValue;
+	}
+
+	//Can a segment from a point in the box to the target pass through the bounds
+	//Every point of such a segment lies in the box scaled towards the target by the distance s in [0, 1] along the segment
+	//The box overlaps the bounds on an axis for an interval of s, the segments can only pass when the 3 intervals overlap
+	bool CanSegmentsPassThrough(const AABB& box, const Vector3& target, const AABB& bounds)
+	{
+		float sMin{ 0.f };
+		float sMax{ 1.f };
+		//c + s * k <= 0 limits s to one side of -c / k
+		const auto clip = [&](float c, float k)
+		{
+			if (k == 0.f)
+				return c <= 0.f;
+			if (k > 0.f)
+				sMax = std::min(sMax, -c / k);
+			else
+				sMin = std::max(sMin, -c / k);
+			return sMin <= sMax;
+		};
+
+		for (int axis{}; axis < 3; ++axis)
+		{
+			//box.min + s * (target - box.min) <= bounds.max and box.max + s * (target - box.max) >= bounds.min
+			if (!clip(box.min[axis] - bounds.max[axis], target[axis] - box.min[axis])
+				|| !clip(bounds.min[axis] - box.max[axis], box.max[axis] - target[axis]))
+				return false;
+		}
+		return true;
+	}
+
+	//Hash of the pixel and sample to [0, 1), jitters the samples inside their strata
+	float GetSampleJitter(uint32_t pixelIndex, uint32_t sampleIndex)
+	{
+		uint32_t hash{ pixelIndex * 0x9E3779B9u ^ sampleIndex * 0x85EBCA6Bu };
+		hash ^= hash >> 16;
+		hash *= 0x7FEB352Du;
+		hash ^= hash >> 15;
+		hash *= 0x846CA68Bu;
+		hash ^= hash >> 16;
+		return static_cast<float>(hash >> 8) / 16777216.f;
+	}
+
+	//Blue over green and yellow to red, logarithmic so cheap pixels still differ from each other
+	ColorRGB GetHeatmapColor(uint32_t cost)
+	{
+		const float value{ std::min(std::log2(1.f + static_cast<float>(cost)) / std::log2(1.f + HEATMAP_MAX_COST), 1.f) };
+		const ColorRGB stops[]{ colors::Blue, colors::Green, colors::Yellow, colors::Red };
+		const float position{ value * 3.f };
+		const int stopIndex{ std::min(static_cast<int>(position), 2) };
+		return ColorRGB::Lerp(stops[stopIndex], stops[stopIndex + 1], position - static_cast<float>(stopIndex));
+	}
+}
+
 Renderer::Renderer(SDL_Window * pWindow) :
 	m_pWindow(pWindow),
 	m_pBuffer(SDL_GetWindowSurface(pWindow))
 {
+	//The window surface can't be created (e.g. out of memory), IsValid() reports it
+	if (!m_pBuffer)
+		return;
+
+	//Initialize
+	SDL_GetWindowSize(pWindow, &m_OutputWidth, &m_OutputHeight);
+	InitializeBuffers();
+
+	SelectKernels();
+
+#if defined(PARALLEL_EXECUTION)
+	SetThreadCount(0);
+#else
+	//Synchronous logic (no threading)
+	SetThreadCount(1);
+#endif
+}
+
+Renderer::Renderer(uint32_t width, uint32_t height) :
+	m_pBuffer(SDL_CreateRGBSurfaceWithFormat(0, static_cast<int>(width), static_cast<int>(height), 32, SDL_PIXELFORMAT_ARGB8888)),
+	m_OwnsBuffer(true),
+	m_OutputWidth(static_cast<int>(width)),
+	m_OutputHeight(static_cast<int>(height))
+{
+	//Too large or out of memory, IsValid() reports it
+	if (!m_pBuffer)
+		return;
+
 	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+	InitializeBuffers();
+
+	SelectKernels();
+
+#if defined(PARALLEL_EXECUTION)
+	SetThreadCount(0);
+#else
+	//Synchronous logic (no threading)
+	SetThreadCount(1);
+#endif
+}
+
+Renderer::~Renderer()
+{
+	//The window surface belongs to the window
+	if (m_OwnsBuffer)
+		SDL_FreeSurface(m_pBuffer);
+}
+
+void Renderer::InitializeBuffers()
+{
 	m_pBufferPixels = static_cast<uint32_t*>(m_pBuffer->pixels);
+	m_BufferRowStride = static_cast<uint32_t>(m_pBuffer->pitch) / sizeof(uint32_t);
+
+	const SDL_PixelFormat* pFormat{ m_pBuffer->format };
+	m_RedShift = pFormat->Rshift;
+	m_GreenShift = pFormat->Gshift;
+	m_BlueShift = pFormat->Bshift;
+	//Same as SDL_MapRGB: opaque when the format has alpha
+	m_AlphaMask = pFormat->Amask;
+
+	//Sized for the full resolution, a lower render scale uses only the start of every buffer
+	m_Width = m_OutputWidth;
+	m_Height = m_OutputHeight;
+	const size_t pixelCount{ static_cast<size_t>(m_Width) * m_Height };
+	const size_t paddedPixelCount{ (pixelCount + SIMD::MAX_WIDTH - 1) / SIMD::MAX_WIDTH * SIMD::MAX_WIDTH };
+	m_HDRBuffer.red.resize(paddedPixelCount);
+	m_HDRBuffer.green.resize(paddedPixelCount);
+	m_HDRBuffer.blue.resize(paddedPixelCount);
+	if constexpr (RAY_STATISTICS_ENABLED)
+		m_PixelCosts.resize(pixelCount);
+
+	m_DirtyTiles.resize(GetTileCount());
+	m_TileIsDirty.resize(GetTileCount());
+	m_TileHitBounds.resize(GetTileCount());
 }
 
-void Renderer::Render(Scene* pScene) const
+void Renderer::Render(Scene* pScene)
 {
+	pScene->UpdateAccelerationStructure();
+	SceneRenderView view{ pScene->GetRenderView() };
+	view.pKernels = m_pKernels;
+	const SceneChanges& changes{ pScene->GetChanges() };
+
 	Camera& camera = pScene->GetCamera();
 	const Matrix cameraToWorld = camera.CalculateCameraToWorld();
 
-	const float aspectRatio = static_cast<float>(m_Width) / static_cast<float>(m_Height);
+	//The render resolution is rounded, the surface has the exact aspect ratio
+	const float aspectRatio = static_cast<float>(m_OutputWidth) / static_cast<float>(m_OutputHeight);
 	const float fov = tan(camera.fovAngle * TO_RADIANS / 2.f);
 
-#if defined(PARALLEL_EXECUTION)
-	//Parallel Logic
-	const uint32_t amountOfPixels{ static_cast<uint32_t>(m_Width * m_Height) };
-	std::vector<uint32_t> pixelIndices{};
-	pixelIndices.reserve(amountOfPixels);
-	for (uint32_t index{}; index < amountOfPixels; ++index) pixelIndices.emplace_back(index);
-
-	std::for_each(std::execution::par, pixelIndices.begin(), pixelIndices.end(),
-		[&](const uint32_t i) {
-		RenderPixel(pScene, i, fov, aspectRatio, cameraToWorld, camera.origin);
-	});
+	if (pScene != m_pRenderedScene || changes.isFullyDirty)
+		m_IsFullyDirty = true;
+	m_pRenderedScene = pScene;
 
-#else
-	//Synchronous logic (no threading)
-	const uint32_t amountOfPixels{ static_cast<uint32_t>(m_Width * m_Height) };
-	for (uint32_t pixelIndex{}; pixelIndex < amountOfPixels; ++pixelIndex)
+	if (!m_IsFullyDirty && changes.dirtyMeshBounds.empty())
 	{
-		RenderPixel(pScene, pixelIndex, fov, aspectRatio, cameraToWorld, camera.origin);
+		//Nothing changed, only progressive rendering still has work: another sample of the whole frame
+		if (!m_ProgressiveRenderingEnabled || m_AccumulatedSampleCount >= MAX_ACCUMULATED_SAMPLES)
+		{
+			//The surface already shows the final image
+			m_PrimaryRayCount = 0;
+			m_RayStatistics = {};
+			if (m_pWindow)
+				SDL_UpdateWindowSurface(m_pWindow);
+			return;
+		}
+		SelectAllTiles();
 	}
-#endif
+	else if (!m_IsFullyDirty && m_AccumulatedSampleCount == 1)
+	{
+		//Only meshes moved, the pixels outside their tiles still hold their one (centered) sample
+		m_AccumulatedSampleCount = 0;
+		SelectDirtyTiles(view, changes.dirtyMeshBounds, fov, aspectRatio, cameraToWorld);
+	}
+	else
+	{
+		m_AccumulatedSampleCount = 0;
+		SelectAllTiles();
+	}
+	m_IsFullyDirty = false;
+
+	m_PrimaryRayCount = 0;
+	for (uint32_t dirtyTileIndex{}; dirtyTileIndex < m_DirtyTileCount; ++dirtyTileIndex)
+	{
+		const PixelRect tile{ GetTileRect(m_DirtyTiles[dirtyTileIndex]) };
+		m_PrimaryRayCount += static_cast<uint64_t>(tile.endX - tile.firstX) * (tile.endY - tile.firstY);
+	}
+
+	//The first sample goes through the pixel center, progressive samples are spread over the pixel
+	m_SampleOffsetX = m_AccumulatedSampleCount == 0 ? 0.5f : GetRadicalInverse(m_AccumulatedSampleCount, 2);
+	m_SampleOffsetY = m_AccumulatedSampleCount == 0 ? 0.5f : GetRadicalInverse(m_AccumulatedSampleCount, 3);
+
+	//Tiles are handed out by the thread pool, no per frame allocations
+	if (m_DeferredShadingEnabled)
+	{
+		//Visibility pass
+		m_pThreadPool->ParallelFor(m_DirtyTileCount,
+			[&](uint32_t dirtyTileIndex) {
+			RenderGBufferTile(view, m_DirtyTiles[dirtyTileIndex], fov, aspectRatio, cameraToWorld, camera.origin);
+		});
+
+		//Shading pass, chunks of the material sorted pixels
+		const uint32_t hitCount{ SortGBufferByMaterial() };
+		m_pThreadPool->ParallelFor((hitCount + SHADE_CHUNK_SIZE - 1) / SHADE_CHUNK_SIZE,
+			[&](uint32_t chunkIndex) {
+			ShadeChunk(view, chunkIndex, hitCount, fov, aspectRatio, cameraToWorld, camera.origin);
+		});
+	}
+	else
+	{
+		m_pThreadPool->ParallelFor(m_DirtyTileCount,
+			[&](uint32_t dirtyTileIndex) {
+			(this->*m_pRenderTileKernel)(view, m_DirtyTiles[dirtyTileIndex], fov, aspectRatio, cameraToWorld, camera.origin);
+		});
+	}
+
+	//Adaptive anti-aliasing, only the first sample of a pixel is supersampled
+	if (m_AdaptiveAAEnabled && m_AccumulatedSampleCount == 0)
+	{
+		m_pThreadPool->ParallelFor(m_DirtyTileCount,
+			[this](uint32_t dirtyTileIndex) {
+			DetectEdges(m_DirtyTiles[dirtyTileIndex]);
+		});
+
+		const uint32_t samplesPerAxis{ SelectEdgePixels() };
+		const uint32_t edgePixelCount{ static_cast<uint32_t>(m_EdgeBuffer.pixels.size()) };
+		if (samplesPerAxis > 0)
+		{
+			m_PrimaryRayCount += static_cast<uint64_t>(edgePixelCount) * samplesPerAxis * samplesPerAxis;
+			m_pThreadPool->ParallelFor((edgePixelCount + SUPERSAMPLE_CHUNK_SIZE - 1) / SUPERSAMPLE_CHUNK_SIZE,
+				[&](uint32_t chunkIndex) {
+				(this->*m_pSupersampleChunkKernel)(view, chunkIndex, samplesPerAxis, fov, aspectRatio, cameraToWorld, camera.origin);
+			});
+		}
+	}
+
+	//All rays of the frame are traced
+	m_RayStatistics = StatisticsUtils::CollectRayStatistics();
+	m_RayStatistics.primaryRays = m_PrimaryRayCount;
+
+	//Display
+	++m_AccumulatedSampleCount;
+	const uint32_t outputPixelCount{ static_cast<uint32_t>(m_OutputWidth * m_OutputHeight) };
+	m_pThreadPool->ParallelFor((outputPixelCount + PACK_CHUNK_SIZE - 1) / PACK_CHUNK_SIZE,
+		[this](uint32_t chunkIndex) {
+		ToneMapAndPack(chunkIndex);
+	});
 
 	//@END
 	//Update SDL Surface
-	SDL_UpdateWindowSurface(m_pWindow);
+	if (m_pWindow)
+		SDL_UpdateWindowSurface(m_pWindow);
 }
 
-void Renderer::RenderPixel(const Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio,
-	const Matrix& cameraToWorld, const Vector3& cameraOrigin) const
+template<typename HitFunction>
+void Renderer::TraceTile(const SceneRenderView& view, uint32_t tileIndex, float fov, float aspectRatio,
+	const Matrix& cameraToWorld, const Vector3& cameraOrigin, const HitFunction& onHit)
 {
-	const auto& materials = pScene->GetMaterials();
-	const auto& lights = pScene->GetLights();
+	const PixelRect tile{ GetTileRect(tileIndex) };
 
-	const uint32_t px{ pixelIndex % m_Width }, py{ pixelIndex / m_Width };
+	//The tile remembers the bounds of the surface points it hit for the dirty tracking of the next frames
+	//and every pixel what its first sample hit for the edge detection of adaptive anti-aliasing
+	const bool writeEdgeBuffer{ m_AdaptiveAAEnabled && m_AccumulatedSampleCount == 0 };
+	AABB hitBounds{};
+	const auto onHitStoreDistance = [&](uint32_t px, uint32_t py, const HitRecord& closestHit, const Vector3& rayDirection)
+	{
+		if (closestHit.didHit)
+			hitBounds.Grow(cameraOrigin + rayDirection * closestHit.t);
+		if (writeEdgeBuffer)
+			WriteEdgeBuffer(px + py * m_Width, closestHit);
+		onHit(px, py, closestHit, rayDirection);
+	};
 
-	//Calculate NDC coordinates
-	const float x = (2.f * ((static_cast<float>(px)+0.5f) / static_cast<float>(m_Width)) -1.f) * aspectRatio * fov;
-	const float y = (1.f - 2.f * ((static_cast<float>(py) + 0.5f) / static_cast<float>(m_Height))) * fov;
+	if (m_PacketTracingEnabled)
+	{
+		//The tile size is a multiple of the packet width, so packets never cross tiles
+		for (uint32_t py{ tile.firstY }; py < tile.endY; py += RayPacket::WIDTH)
+		{
+			for (uint32_t px{ tile.firstX }; px < tile.endX; px += RayPacket::WIDTH)
+			{
+				TracePacket(view, px, py, fov, aspectRatio, cameraToWorld, cameraOrigin, onHitStoreDistance);
+			}
+		}
+	}
+	else
+	{
+		for (uint32_t py{ tile.firstY }; py < tile.endY; ++py)
+		{
+			for (uint32_t px{ tile.firstX }; px < tile.endX; ++px)
+			{
+				TracePixel(view, px, py, fov, aspectRatio, cameraToWorld, cameraOrigin, onHitStoreDistance);
+			}
+		}
+	}
+	m_TileHitBounds[tileIndex] = hitBounds;
+}
 
-	Vector3 rayDirection{ x, y, 1.f };
-	rayDirection = cameraToWorld.TransformVector(rayDirection.Normalized());
+template<typename HitFunction>
+void Renderer::TracePixel(const SceneRenderView& view, uint32_t px, uint32_t py, float fov, float aspectRatio,
+	const Matrix& cameraToWorld, const Vector3& cameraOrigin, const HitFunction& onHit)
+{
+	const Vector3 rayDirection{ GetViewDirection(px, py, fov, aspectRatio, cameraToWorld) };
 
 	//Ray we are casting from camera towards each pixel
 	const Ray viewRay{ cameraOrigin, rayDirection };
 
-	//Color to write to the color buffer (default = black)
-	ColorRGB finalColor{};
-
 	//HitRecord containing more information about a potential hit
 	HitRecord closestHit{};
-	pScene->GetClosestHit(viewRay, closestHit);
+	[[maybe_unused]] const uint64_t firstTestCount{ StatisticsUtils::GetThreadTestCount() };
+	view.GetClosestHit(viewRay, closestHit);
+	if constexpr (RAY_STATISTICS_ENABLED)
+		m_PixelCosts[px + py * m_Width] = static_cast<uint32_t>(StatisticsUtils::GetThreadTestCount() - firstTestCount);
+
+	onHit(px, py, closestHit, rayDirection);
+}
+
+template<typename HitFunction>
+void Renderer::TracePacket(const SceneRenderView& view, uint32_t firstX, uint32_t firstY, float fov, float aspectRatio,
+	const Matrix& cameraToWorld, const Vector3& cameraOrigin, const HitFunction& onHit)
+{
+	//Packets at the right and bottom border can be smaller
+	const uint32_t packetWidth{ std::min(RayPacket::WIDTH, m_Width - firstX) };
+	const uint32_t packetHeight{ std::min(RayPacket::WIDTH, m_Height - firstY) };
 
-	if (closestHit.didHit)
+	RayPacket packet{};
+	packet.rayCount = packetWidth * packetHeight;
+	for (uint32_t y{}; y < packetHeight; ++y)
 	{
-		for (const Light& light : lights)
+		for (uint32_t x{}; x < packetWidth; ++x)
 		{
-			const Vector3 hitOrigin{ closestHit.origin };
-			Vector3 directionToLight{ LightUtils::GetDirectionToLight(light, hitOrigin) };
-			const float rayMax{ directionToLight.Normalize() };
+			packet.rays[x + y * packetWidth] = Ray{ cameraOrigin, GetViewDirection(firstX + x, firstY + y, fov, aspectRatio, cameraToWorld) };
+		}
+	}
+
+	//Rays through the corner pixels span the frustum of the whole packet
+	packet.cornerDirections[0] = packet.rays[0].direction;
+	packet.cornerDirections[1] = packet.rays[packetWidth - 1].direction;
+	packet.cornerDirections[2] = packet.rays[packet.rayCount - 1].direction;
+	packet.cornerDirections[3] = packet.rays[packet.rayCount - packetWidth].direction;
+	packet.frustum = Frustum{ cameraOrigin, packet.cornerDirections };
+
+	HitRecord closestHits[RayPacket::MAX_SIZE]{};
+	[[maybe_unused]] const uint64_t firstTestCount{ StatisticsUtils::GetThreadTestCount() };
+	view.GetClosestHits(packet, closestHits);
+	if constexpr (RAY_STATISTICS_ENABLED)
+	{
+		//The traversal is shared by the rays of the packet, the first rays get the remainder
+		const uint32_t packetCost{ static_cast<uint32_t>(StatisticsUtils::GetThreadTestCount() - firstTestCount) };
+		for (uint32_t rayIndex{}; rayIndex < packet.rayCount; ++rayIndex)
+		{
+			const uint32_t pixelIndex{ firstX + rayIndex % packetWidth + (firstY + rayIndex / packetWidth) * m_Width };
+			m_PixelCosts[pixelIndex] = packetCost / packet.rayCount + (rayIndex < packetCost % packet.rayCount ? 1 : 0);
+		}
+	}
+
+	for (uint32_t rayIndex{}; rayIndex < packet.rayCount; ++rayIndex)
+	{
+		onHit(firstX + rayIndex % packetWidth, firstY + rayIndex / packetWidth, closestHits[rayIndex], packet.rays[rayIndex].direction);
+	}
+}
+
+Vector3 Renderer::GetViewDirection(uint32_t px, uint32_t py, float fov, float aspectRatio, const Matrix& cameraToWorld) const
+{
+	return GetSampleDirection(static_cast<float>(px) + m_SampleOffsetX, static_cast<float>(py) + m_SampleOffsetY, fov, aspectRatio, cameraToWorld);
+}
+
+Vector3 Renderer::GetSampleDirection(float screenX, float screenY, float fov, float aspectRatio, const Matrix& cameraToWorld) const
+{
+	//Calculate NDC coordinates
+	const float x = (2.f * (screenX / static_cast<float>(m_Width)) -1.f) * aspectRatio * fov;
+	const float y = (1.f - 2.f * (screenY / static_cast<float>(m_Height))) * fov;
+
+	const Vector3 rayDirection{ x, y, 1.f };
+	return cameraToWorld.TransformVector(rayDirection.Normalized());
+}
+
+void Renderer::WritePixel(uint32_t pixelIndex, const ColorRGB& color)
+{
+	if (m_AccumulatedSampleCount == 0)
+	{
+		m_HDRBuffer.red[pixelIndex] = color.r;
+		m_HDRBuffer.green[pixelIndex] = color.g;
+		m_HDRBuffer.blue[pixelIndex] = color.b;
+	}
+	else
+	{
+		m_HDRBuffer.red[pixelIndex] += color.r;
+		m_HDRBuffer.green[pixelIndex] += color.g;
+		m_HDRBuffer.blue[pixelIndex] += color.b;
+	}
+}
+
+void Renderer::ToneMapAndPack(uint32_t chunkIndex)
+{
+	const HDRImage hdrImage{ m_HDRBuffer.red.data(), m_HDRBuffer.green.data(), m_HDRBuffer.blue.data(),
+		static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height) };
+	const SurfaceImage surfaceImage{ m_pBufferPixels, static_cast<uint32_t>(m_OutputWidth), static_cast<uint32_t>(m_OutputHeight), m_BufferRowStride,
+		m_RedShift, m_GreenShift, m_BlueShift, m_AlphaMask };
+
+	const uint32_t pixelCount{ static_cast<uint32_t>(m_OutputWidth * m_OutputHeight) };
+	const uint32_t firstPixel{ chunkIndex * PACK_CHUNK_SIZE };
+	const uint32_t endPixel{ std::min(firstPixel + PACK_CHUNK_SIZE, pixelCount) };
+	//Average of the accumulated samples
+	m_pToneMapKernel(hdrImage, 1.f / static_cast<float>(m_AccumulatedSampleCount), surfaceImage, firstPixel, endPixel);
+}
+
+#pragma region Dirty Tracking
+uint32_t Renderer::GetTileCount() const
+{
+	const uint32_t tilesPerRow{ (m_Width + m_TileSize - 1) / m_TileSize };
+	const uint32_t tilesPerColumn{ (m_Height + m_TileSize - 1) / m_TileSize };
+	return tilesPerRow * tilesPerColumn;
+}
+
+Renderer::PixelRect Renderer::GetTileRect(uint32_t tileIndex) const
+{
+	const uint32_t tilesPerRow{ (m_Width + m_TileSize - 1) / m_TileSize };
+	const uint32_t firstX{ (tileIndex % tilesPerRow) * m_TileSize };
+	const uint32_t firstY{ (tileIndex / tilesPerRow) * m_TileSize };
+
+	//Tiles at the right and bottom border can be smaller
+	return PixelRect{ firstX, firstY,
+		std::min(firstX + m_TileSize, static_cast<uint32_t>(m_Width)),
+		std::min(firstY + m_TileSize, static_cast<uint32_t>(m_Height)) };
+}
+
+Renderer::PixelRect Renderer::GetScreenRect(const AABB& bounds, float fov, float aspectRatio, const Matrix& worldToCamera) const
+{
+	const PixelRect screen{ 0, 0, static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height) };
 
-			if (m_ShadowsEnabled)
+	//Projects the 8 corners, inverse of GetViewDirection
+	float minX{ FLT_MAX }, minY{ FLT_MAX }, maxX{ -FLT_MAX }, maxY{ -FLT_MAX };
+	for (int corner{}; corner < 8; ++corner)
+	{
+		const Vector3 point{ worldToCamera.TransformPoint(
+			corner & 1 ? bounds.max.x : bounds.min.x,
+			corner & 2 ? bounds.max.y : bounds.min.y,
+			corner & 4 ? bounds.max.z : bounds.min.z) };
+		if (point.z <= FLT_EPSILON)
+			return screen;
+
+		const float x{ (point.x / (point.z * aspectRatio * fov) + 1.f) * 0.5f * static_cast<float>(m_Width) };
+		const float y{ (1.f - point.y / (point.z * fov)) * 0.5f * static_cast<float>(m_Height) };
+		minX = std::min(minX, x);
+		minY = std::min(minY, y);
+		maxX = std::max(maxX, x);
+		maxY = std::max(maxY, y);
+	}
+
+	//One extra pixel on every side covers the pixels whose center is just outside
+	const auto toPixel = [](float value, int size) { return static_cast<uint32_t>(std::clamp(value, 0.f, static_cast<float>(size))); };
+	return PixelRect{ toPixel(minX - 1.f, m_Width), toPixel(minY - 1.f, m_Height), toPixel(maxX + 2.f, m_Width), toPixel(maxY + 2.f, m_Height) };
+}
+
+void Renderer::SelectAllTiles()
+{
+	m_DirtyTileCount = GetTileCount();
+	for (uint32_t tileIndex{}; tileIndex < m_DirtyTileCount; ++tileIndex)
+	{
+		m_DirtyTiles[tileIndex] = tileIndex;
+	}
+}
+
+void Renderer::SelectDirtyTiles(const SceneRenderView& view, const std::vector<AABB>& dirtyBounds, float fov, float aspectRatio,
+	const Matrix& cameraToWorld)
+{
+	const Matrix worldToCamera{ Matrix::Inverse(cameraToWorld) };
+	m_DirtyRects.clear();
+	for (const AABB& bounds : dirtyBounds)
+	{
+		m_DirtyRects.push_back(GetScreenRect(bounds, fov, aspectRatio, worldToCamera));
+	}
+
+	const uint32_t tileCount{ GetTileCount() };
+	m_pThreadPool->ParallelFor(tileCount,
+		[&](uint32_t tileIndex) {
+		m_TileIsDirty[tileIndex] = IsTileDirty(view, tileIndex, dirtyBounds);
+	});
+
+	m_DirtyTileCount = 0;
+	for (uint32_t tileIndex{}; tileIndex < tileCount; ++tileIndex)
+	{
+		if (m_TileIsDirty[tileIndex])
+			m_DirtyTiles[m_DirtyTileCount++] = tileIndex;
+	}
+}
+
+bool Renderer::IsTileDirty(const SceneRenderView& view, uint32_t tileIndex, const std::vector<AABB>& dirtyBounds) const
+{
+	//Primary rays through the tile can hit the moved meshes
+	const PixelRect tile{ GetTileRect(tileIndex) };
+	for (const PixelRect& rect : m_DirtyRects)
+	{
+		if (tile.Overlaps(rect))
+			return true;
+	}
+
+	//The visible surfaces didn't change, but their shadow rays can pass through the old or new bounds
+	const AABB& hitBounds{ m_TileHitBounds[tileIndex] };
+	if (!m_ShadowsEnabled || hitBounds.min.x > hitBounds.max.x)
+		return false;
+
+	//Tests all shadow rays of the tile at once: segments from anywhere in its hit bounds to the light
+	//Conservative, the boxes are grown slightly to be safe from rounding
+	constexpr float margin{ 0.001f };
+	const Vector3 marginExtent{ margin, margin, margin };
+	for (const Light& light : view.lights)
+	{
+		//Shadow rays of both light types end in one point, the direction to the light from the world origin
+		const Vector3 lightPosition{ LightUtils::GetDirectionToLight(light, Vector3::Zero) };
+		for (const AABB& bounds : dirtyBounds)
+		{
+			const AABB grownBounds{ bounds.min - marginExtent, bounds.max + marginExtent };
+			if (CanSegmentsPassThrough(hitBounds, lightPosition, grownBounds))
+				return true;
+		}
+	}
+	return false;
+}
+#pragma endregion
+
+#pragma region Forward Shading
+template<LightingMode lightingMode, bool shadowsEnabled>
+void Renderer::RenderTile(const SceneRenderView& view, uint32_t tileIndex, float fov, float aspectRatio,
+	const Matrix& cameraToWorld, const Vector3& cameraOrigin)
+{
+	TraceTile(view, tileIndex, fov, aspectRatio, cameraToWorld, cameraOrigin,
+		[&](uint32_t px, uint32_t py, const HitRecord& closestHit, const Vector3& rayDirection) {
+		ShadePixel<lightingMode, shadowsEnabled>(view, px, py, closestHit, rayDirection);
+	});
+}
+
+template<LightingMode lightingMode, bool shadowsEnabled>
+void Renderer::ShadePixel(const SceneRenderView& view, uint32_t px, uint32_t py, const HitRecord& closestHit, const Vector3& rayDirection)
+{
+	const uint32_t pixelIndex{ px + (py * m_Width) };
+	if constexpr (lightingMode == LightingMode::Cost)
+	{
+		//The lighting is still evaluated, its shadow rays are part of the cost
+		const uint64_t firstTestCount{ StatisticsUtils::GetThreadTestCount() };
+		m_pShadeHitKernel(view, closestHit, rayDirection);
+		m_PixelCosts[pixelIndex] += static_cast<uint32_t>(StatisticsUtils::GetThreadTestCount() - firstTestCount);
+		WritePixel(pixelIndex, GetHeatmapColor(m_PixelCosts[pixelIndex]));
+	}
+	else
+	{
+		//Update Color in Buffer
+		WritePixel(pixelIndex, m_pShadeHitKernel(view, closestHit, rayDirection));
+	}
+}
+#pragma endregion
+
+#pragma region Deferred Shading
+void Renderer::RenderGBufferTile(const SceneRenderView& view, uint32_t tileIndex, float fov, float aspectRatio,
+	const Matrix& cameraToWorld, const Vector3& cameraOrigin)
+{
+	TraceTile(view, tileIndex, fov, aspectRatio, cameraToWorld, cameraOrigin,
+		[&](uint32_t px, uint32_t py, const HitRecord& closestHit, const Vector3&) {
+		WriteGBuffer(px, py, closestHit);
+	});
+}
+
+void Renderer::WriteGBuffer(uint32_t px, uint32_t py, const HitRecord& closestHit)
+{
+	const uint32_t pixelIndex{ px + py * m_Width };
+	if (!closestHit.didHit)
+	{
+		//Nothing to shade, background is black (the Cost lighting mode still shows the traversal)
+		m_GBuffer.materialIndices[pixelIndex] = GBuffer::MISS;
+		WritePixel(pixelIndex, m_CurrentLightingMode == LightingMode::Cost ? GetHeatmapColor(m_PixelCosts[pixelIndex]) : ColorRGB{});
+		return;
+	}
+
+	//The hit origin is rebuilt from t and the view ray in the shading pass
+	m_GBuffer.t[pixelIndex] = closestHit.t;
+	m_GBuffer.normalX[pixelIndex] = closestHit.normal.x;
+	m_GBuffer.normalY[pixelIndex] = closestHit.normal.y;
+	m_GBuffer.normalZ[pixelIndex] = closestHit.normal.z;
+	m_GBuffer.materialIndices[pixelIndex] = closestHit.materialIndex;
+}
+
+uint32_t Renderer::SortGBufferByMaterial()
+{
+	//Only the pixels of the dirty tiles were traced again
+	const auto forEachDirtyPixel = [this](const auto& function)
+	{
+		for (uint32_t dirtyTileIndex{}; dirtyTileIndex < m_DirtyTileCount; ++dirtyTileIndex)
+		{
+			const PixelRect tile{ GetTileRect(m_DirtyTiles[dirtyTileIndex]) };
+			for (uint32_t py{ tile.firstY }; py < tile.endY; ++py)
 			{
-				const Ray shadowRay{ hitOrigin, directionToLight, 0.001f, rayMax };
-				if (pScene->DoesHit((shadowRay))) continue;
+				for (uint32_t px{ tile.firstX }; px < tile.endX; ++px)
+				{
+					function(px + py * m_Width);
+				}
 			}
+		}
+	};
+
+	//Counting sort, pixels of the same material stay in tile order
+	//materialFirstPixel[i + 1] counts material i first, then becomes the start of material i + 1
+	uint32_t materialFirstPixel[UINT8_MAX + 2]{};
+	forEachDirtyPixel([&](uint32_t pixelIndex)
+	{
+		const uint16_t materialIndex{ m_GBuffer.materialIndices[pixelIndex] };
+		if (materialIndex != GBuffer::MISS)
+			++materialFirstPixel[materialIndex + 1];
+	});
+
+	for (uint32_t materialIndex{ 1 }; materialIndex < UINT8_MAX + 2; ++materialIndex)
+	{
+		materialFirstPixel[materialIndex] += materialFirstPixel[materialIndex - 1];
+	}
+	const uint32_t hitCount{ materialFirstPixel[UINT8_MAX + 1] };
+
+	forEachDirtyPixel([&](uint32_t pixelIndex)
+	{
+		const uint16_t materialIndex{ m_GBuffer.materialIndices[pixelIndex] };
+		if (materialIndex != GBuffer::MISS)
+			m_GBuffer.shadeOrder[materialFirstPixel[materialIndex]++] = pixelIndex;
+	});
+	return hitCount;
+}
+
+void Renderer::ShadeChunk(const SceneRenderView& view, uint32_t chunkIndex, uint32_t hitCount, float fov, float aspectRatio,
+	const Matrix& cameraToWorld, const Vector3& cameraOrigin)
+{
+	const uint32_t* pPixelIndices{ m_GBuffer.shadeOrder.data() };
+	const uint32_t end{ std::min((chunkIndex + 1) * SHADE_CHUNK_SIZE, hitCount) };
+
+	uint32_t first{ chunkIndex * SHADE_CHUNK_SIZE };
+	while (first < end)
+	{
+		//A group never mixes materials
+		const uint16_t materialIndex{ m_GBuffer.materialIndices[pPixelIndices[first]] };
+		uint32_t count{ 1 };
+		while (count < m_pKernels->width && first + count < end && m_GBuffer.materialIndices[pPixelIndices[first + count]] == materialIndex)
+			++count;
+
+		ShadeGroup(view, pPixelIndices + first, count, fov, aspectRatio, cameraToWorld, cameraOrigin);
+		first += count;
+	}
+}
+
+void Renderer::ShadeGroup(const SceneRenderView& view, const uint32_t* pPixelIndices, uint32_t count, float fov, float aspectRatio,
+	const Matrix& cameraToWorld, const Vector3& cameraOrigin)
+{
+	//Gather the samples, unused lanes repeat the last pixel so every lane holds valid data
+	SurfaceSamples samples;
+	for (uint32_t lane{}; lane < m_pKernels->width; ++lane)
+	{
+		const uint32_t pixelIndex{ pPixelIndices[std::min(lane, count - 1)] };
+		const Vector3 rayDirection{ GetViewDirection(pixelIndex % m_Width, pixelIndex / m_Width, fov, aspectRatio, cameraToWorld) };
+		const Vector3 hitOrigin{ cameraOrigin + rayDirection * m_GBuffer.t[pixelIndex] };
+
+		samples.originX[lane] = hitOrigin.x;
+		samples.originY[lane] = hitOrigin.y;
+		samples.originZ[lane] = hitOrigin.z;
+		//invert rayDirection
+		samples.viewX[lane] = -rayDirection.x;
+		samples.viewY[lane] = -rayDirection.y;
+		samples.viewZ[lane] = -rayDirection.z;
+		samples.normalX[lane] = m_GBuffer.normalX[pixelIndex];
+		samples.normalY[lane] = m_GBuffer.normalY[pixelIndex];
+		samples.normalZ[lane] = m_GBuffer.normalZ[pixelIndex];
+	}
+
+	const Material& material{ view.materials[m_GBuffer.materialIndices[pPixelIndices[0]]] };
+	SampleColors colors;
+	m_pShadeSamplesKernel(view, material, samples, count, colors);
+
+	if (m_CurrentLightingMode == LightingMode::Cost)
+	{
+		for (uint32_t lane{}; lane < count; ++lane)
+		{
+			const uint32_t pixelIndex{ pPixelIndices[lane] };
+			m_PixelCosts[pixelIndex] += colors.costs[lane];
+			WritePixel(pixelIndex, GetHeatmapColor(m_PixelCosts[pixelIndex]));
+		}
+		return;
+	}
 
-			const ColorRGB radiance{ LightUtils::GetRadiance(light, closestHit.origin) };
-			const float observedArea{ std::max(Vector3::Dot(closestHit.normal, directionToLight), 0.f) };
-			const ColorRGB BRDF{ materials[closestHit.materialIndex]->Shade(closestHit, directionToLight, -rayDirection) }; //invert rayDirection
+	//Update Color in Buffer
+	for (uint32_t lane{}; lane < count; ++lane)
+	{
+		WritePixel(pPixelIndices[lane], ColorRGB{ colors.red[lane], colors.green[lane], colors.blue[lane] });
+	}
+}
+#pragma endregion
 
-			switch (m_CurrentLightingMode)
+#pragma region Adaptive Anti-Aliasing
+void Renderer::WriteEdgeBuffer(uint32_t pixelIndex, const HitRecord& closestHit)
+{
+	m_EdgeBuffer.materialIndices[pixelIndex] = closestHit.didHit ? closestHit.materialIndex : EdgeBuffer::MISS;
+	m_EdgeBuffer.normalX[pixelIndex] = closestHit.normal.x;
+	m_EdgeBuffer.normalY[pixelIndex] = closestHit.normal.y;
+	m_EdgeBuffer.normalZ[pixelIndex] = closestHit.normal.z;
+}
+
+void Renderer::DetectEdges(uint32_t tileIndex)
+{
+	const auto getLuminance = [this](uint32_t pixelIndex)
+	{
+		return GetDisplayedLuminance(m_HDRBuffer.red[pixelIndex], m_HDRBuffer.green[pixelIndex], m_HDRBuffer.blue[pixelIndex]);
+	};
+
+	const PixelRect tile{ GetTileRect(tileIndex) };
+	const uint32_t width{ static_cast<uint32_t>(m_Width) };
+	const uint32_t height{ static_cast<uint32_t>(m_Height) };
+	for (uint32_t py{ tile.firstY }; py < tile.endY; ++py)
+	{
+		for (uint32_t px{ tile.firstX }; px < tile.endX; ++px)
+		{
+			const uint32_t pixelIndex{ px + py * width };
+			const uint16_t materialIndex{ m_EdgeBuffer.materialIndices[pixelIndex] };
+			const Vector3 normal{ m_EdgeBuffer.normalX[pixelIndex], m_EdgeBuffer.normalY[pixelIndex], m_EdgeBuffer.normalZ[pixelIndex] };
+			const float luminance{ getLuminance(pixelIndex) };
+
+			//The strongest difference with a neighbour, 0 when there is none
+			float score{};
+			const auto compare = [&](uint32_t neighbourIndex)
 			{
-			case LightingMode::ObservedArea:
-				finalColor += {observedArea, observedArea, observedArea};
-				break;
-			case LightingMode::Radiance:
-				finalColor += radiance;
-				break;
-			case LightingMode::BRDF:
-				finalColor += BRDF;
-				break;
-			case LightingMode::Combined:
-				finalColor += radiance * BRDF * observedArea;
-				break;
+				//Silhouettes and material borders
+				if (m_EdgeBuffer.materialIndices[neighbourIndex] != materialIndex)
+				{
+					score = std::max(score, 1.f);
+					return;
+				}
+
+				if (materialIndex != EdgeBuffer::MISS)
+				{
+					const Vector3 neighbourNormal{ m_EdgeBuffer.normalX[neighbourIndex], m_EdgeBuffer.normalY[neighbourIndex], m_EdgeBuffer.normalZ[neighbourIndex] };
+					const float normalDifference{ 1.f - Vector3::Dot(normal, neighbourNormal) };
+					if (normalDifference > EDGE_NORMAL_THRESHOLD)
+						score = std::max(score, normalDifference);
+				}
+
+				//Shadow borders and highlights
+				const float luminanceDifference{ std::abs(luminance - getLuminance(neighbourIndex)) };
+				if (luminanceDifference > EDGE_LUMINANCE_THRESHOLD)
+					score = std::max(score, luminanceDifference);
+			};
+			if (px > 0) compare(pixelIndex - 1);
+			if (px + 1 < width) compare(pixelIndex + 1);
+			if (py > 0) compare(pixelIndex - width);
+			if (py + 1 < height) compare(pixelIndex + width);
+
+			m_EdgeBuffer.scores[pixelIndex] = score;
+		}
+	}
+}
+
+uint32_t Renderer::SelectEdgePixels()
+{
+	std::vector<uint32_t>& pixels{ m_EdgeBuffer.pixels };
+	pixels.clear();
+	for (uint32_t dirtyTileIndex{}; dirtyTileIndex < m_DirtyTileCount; ++dirtyTileIndex)
+	{
+		const PixelRect tile{ GetTileRect(m_DirtyTiles[dirtyTileIndex]) };
+		for (uint32_t py{ tile.firstY }; py < tile.endY; ++py)
+		{
+			for (uint32_t px{ tile.firstX }; px < tile.endX; ++px)
+			{
+				const uint32_t pixelIndex{ px + py * m_Width };
+				if (m_EdgeBuffer.scores[pixelIndex] > 0.f)
+					pixels.push_back(pixelIndex);
 			}
 		}
+	}
 
+	const uint32_t maxPixelCount{ m_AntiAliasingRayBudget / (MIN_SAMPLES_PER_AXIS * MIN_SAMPLES_PER_AXIS) };
+	if (pixels.empty() || maxPixelCount == 0)
+	{
+		pixels.clear();
+		return 0;
 	}
 
-	//Update Color in Buffer
-	finalColor.MaxToOne();
+	//Over budget: only the strongest edges are supersampled
+	if (pixels.size() > maxPixelCount)
+	{
+		std::nth_element(pixels.begin(), pixels.begin() + maxPixelCount, pixels.end(),
+			[this](uint32_t first, uint32_t second) { return m_EdgeBuffer.scores[first] > m_EdgeBuffer.scores[second]; });
+		pixels.resize(maxPixelCount);
+	}
+
+	//Under budget: the rays that are left go to more samples per pixel
+	const uint32_t samplesPerPixel{ m_AntiAliasingRayBudget / static_cast<uint32_t>(pixels.size()) };
+	return std::clamp(static_cast<uint32_t>(std::sqrt(static_cast<float>(samplesPerPixel))), MIN_SAMPLES_PER_AXIS, MAX_SAMPLES_PER_AXIS);
+}
+
+template<LightingMode lightingMode, bool shadowsEnabled>
+void Renderer::SupersampleChunk(const SceneRenderView& view, uint32_t chunkIndex, uint32_t samplesPerAxis, float fov, float aspectRatio,
+	const Matrix& cameraToWorld, const Vector3& cameraOrigin)
+{
+	const uint32_t firstIndex{ chunkIndex * SUPERSAMPLE_CHUNK_SIZE };
+	const uint32_t endIndex{ std::min(firstIndex + SUPERSAMPLE_CHUNK_SIZE, static_cast<uint32_t>(m_EdgeBuffer.pixels.size())) };
+	const float stratumSize{ 1.f / static_cast<float>(samplesPerAxis) };
+	const float sampleWeight{ stratumSize * stratumSize };
 
-	m_pBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBuffer->format,
-		static_cast<uint8_t>(finalColor.r * 255),
-		static_cast<uint8_t>(finalColor.g * 255),
-		static_cast<uint8_t>(finalColor.b * 255));
+	for (uint32_t index{ firstIndex }; index < endIndex; ++index)
+	{
+		const uint32_t pixelIndex{ m_EdgeBuffer.pixels[index] };
+		const float px{ static_cast<float>(pixelIndex % m_Width) };
+		const float py{ static_cast<float>(pixelIndex / m_Width) };
+
+		//One jittered sample per stratum, they replace the sample through the pixel center
+		[[maybe_unused]] const uint64_t firstTestCount{ StatisticsUtils::GetThreadTestCount() };
+		ColorRGB color{};
+		for (uint32_t sy{}; sy < samplesPerAxis; ++sy)
+		{
+			for (uint32_t sx{}; sx < samplesPerAxis; ++sx)
+			{
+				const uint32_t sampleIndex{ sx + sy * samplesPerAxis };
+				const float x{ px + (static_cast<float>(sx) + GetSampleJitter(pixelIndex, 2 * sampleIndex)) * stratumSize };
+				const float y{ py + (static_cast<float>(sy) + GetSampleJitter(pixelIndex, 2 * sampleIndex + 1)) * stratumSize };
+				const Vector3 rayDirection{ GetSampleDirection(x, y, fov, aspectRatio, cameraToWorld) };
+
+				HitRecord closestHit{};
+				view.GetClosestHit(Ray{ cameraOrigin, rayDirection }, closestHit);
+				color += m_pShadeHitKernel(view, closestHit, rayDirection);
+			}
+		}
+		if constexpr (lightingMode == LightingMode::Cost)
+		{
+			//The first sample was traced as well, so its cost stays
+			m_PixelCosts[pixelIndex] += static_cast<uint32_t>(StatisticsUtils::GetThreadTestCount() - firstTestCount);
+			WritePixel(pixelIndex, GetHeatmapColor(m_PixelCosts[pixelIndex]));
+		}
+		else
+		{
+			WritePixel(pixelIndex, color * sampleWeight);
+		}
+	}
 }
+#pragma endregion
 
-bool Renderer::SaveBufferToImage() const
+void Renderer::SelectKernels()
 {
-	return SDL_SaveBMP(m_pBuffer, "RayTracing_Buffer.bmp");
+	//[lighting mode][shadows enabled], instantiates every kernel (the Cost kernels only with RAY_STATISTICS)
+	static constexpr RenderTileKernel renderTileKernels[][2]
+	{
+		{ &Renderer::RenderTile<LightingMode::ObservedArea, false>, &Renderer::RenderTile<LightingMode::ObservedArea, true> },
+		{ &Renderer::RenderTile<LightingMode::Radiance, false>, &Renderer::RenderTile<LightingMode::Radiance, true> },
+		{ &Renderer::RenderTile<LightingMode::BRDF, false>, &Renderer::RenderTile<LightingMode::BRDF, true> },
+		{ &Renderer::RenderTile<LightingMode::Combined, false>, &Renderer::RenderTile<LightingMode::Combined, true> },
+#if defined(RAY_STATISTICS)
+		{ &Renderer::RenderTile<LightingMode::Cost, false>, &Renderer::RenderTile<LightingMode::Cost, true> },
+#endif
+	};
+	static constexpr SupersampleChunkKernel supersampleChunkKernels[][2]
+	{
+		{ &Renderer::SupersampleChunk<LightingMode::ObservedArea, false>, &Renderer::SupersampleChunk<LightingMode::ObservedArea, true> },
+		{ &Renderer::SupersampleChunk<LightingMode::Radiance, false>, &Renderer::SupersampleChunk<LightingMode::Radiance, true> },
+		{ &Renderer::SupersampleChunk<LightingMode::BRDF, false>, &Renderer::SupersampleChunk<LightingMode::BRDF, true> },
+		{ &Renderer::SupersampleChunk<LightingMode::Combined, false>, &Renderer::SupersampleChunk<LightingMode::Combined, true> },
+#if defined(RAY_STATISTICS)
+		{ &Renderer::SupersampleChunk<LightingMode::Cost, false>, &Renderer::SupersampleChunk<LightingMode::Cost, true> },
+#endif
+	};
+	const int lightingMode{ static_cast<int>(m_CurrentLightingMode) };
+	const int shadows{ m_ShadowsEnabled ? 1 : 0 };
+	m_pRenderTileKernel = renderTileKernels[lightingMode][shadows];
+	m_pSupersampleChunkKernel = supersampleChunkKernels[lightingMode][shadows];
+	m_pShadeHitKernel = m_pKernels->pShadeHit[lightingMode][shadows];
+	m_pShadeSamplesKernel = m_pKernels->pShadeSamples[lightingMode][shadows];
+
+	const bool isUpscaled{ m_Width != m_OutputWidth || m_Height != m_OutputHeight };
+	m_pToneMapKernel = m_pKernels->pToneMap[m_SRGBEnabled ? 1 : 0][isUpscaled ? 1 : 0];
+
+	//The current image was shaded with the old settings
+	m_IsFullyDirty = true;
+}
+
+bool Renderer::SaveBufferToImage(const char* filePath) const
+{
+	return SDL_SaveBMP(m_pBuffer, filePath);
+}
+
+bool Renderer::SaveBufferToRaw(const char* filePath) const
+{
+	std::ofstream file{ filePath, std::ios::binary };
+	if (!file)
+		return true;
+
+	//Rows can be padded in the surface
+	const uint8_t* pRow{ static_cast<const uint8_t*>(m_pBuffer->pixels) };
+	for (int y{}; y < m_OutputHeight; ++y, pRow += m_pBuffer->pitch)
+	{
+		file.write(reinterpret_cast<const char*>(pRow), static_cast<std::streamsize>(m_OutputWidth) * sizeof(uint32_t));
+	}
+	return !file;
 }
 
 void Renderer::CycleLightingMode()
 {
+	//The Cost heatmap needs the counters of RAY_STATISTICS
 	int nextState = static_cast<int>(m_CurrentLightingMode) + 1;
-	nextState %= 4;
+	nextState %= LIGHTING_MODE_COUNT;
 	m_CurrentLightingMode = static_cast<LightingMode>(nextState);
+	SelectKernels();
 
 	std::cout << "[LIGHTING MODE]:\t";
 	switch (m_CurrentLightingMode)
@@ -155,6 +972,9 @@ void Renderer::CycleLightingMode()
 	case LightingMode::Combined:
 		std::cout << "COMBINED";
 		break;
+	case LightingMode::Cost:
+		std::cout << "COST HEATMAP";
+		break;
 	}
 	std::cout << "\n";
 }
@@ -162,6 +982,7 @@ void Renderer::CycleLightingMode()
 void Renderer::ToggleShadows()
 {
 	m_ShadowsEnabled = not m_ShadowsEnabled;
+	SelectKernels();
 
 	std::cout << "[SHADOWS]:\t";
 	if (m_ShadowsEnabled) 
@@ -169,3 +990,139 @@ void Renderer::ToggleShadows()
 	else 
 		std::cout << "OFF\n";
 }
+
+void Renderer::TogglePacketTracing()
+{
+	m_PacketTracingEnabled = not m_PacketTracingEnabled;
+
+	std::cout << "[PACKET TRACING]:\t";
+	if (m_PacketTracingEnabled)
+		std::cout << "ON\n";
+	else
+		std::cout << "OFF\n";
+}
+
+void Renderer::ToggleDeferredShading()
+{
+	m_DeferredShadingEnabled = not m_DeferredShadingEnabled;
+	//The G-buffer only holds the pixels of the frames it was used for
+	m_IsFullyDirty = true;
+
+	//Allocated once, rendering itself never allocates
+	if (m_DeferredShadingEnabled && m_GBuffer.t.empty())
+	{
+		const size_t pixelCount{ static_cast<size_t>(m_OutputWidth) * m_OutputHeight };
+		m_GBuffer.t.resize(pixelCount);
+		m_GBuffer.normalX.resize(pixelCount);
+		m_GBuffer.normalY.resize(pixelCount);
+		m_GBuffer.normalZ.resize(pixelCount);
+		m_GBuffer.materialIndices.resize(pixelCount);
+		m_GBuffer.shadeOrder.resize(pixelCount);
+	}
+
+	std::cout << "[DEFERRED SHADING]:\t";
+	if (m_DeferredShadingEnabled)
+		std::cout << "ON\n";
+	else
+		std::cout << "OFF\n";
+}
+
+void Renderer::ToggleSRGB()
+{
+	m_SRGBEnabled = not m_SRGBEnabled;
+	//Also makes sure the next frame is packed again, unchanged frames are skipped
+	SelectKernels();
+
+	std::cout << "[SRGB]:\t";
+	if (m_SRGBEnabled)
+		std::cout << "ON\n";
+	else
+		std::cout << "OFF\n";
+}
+
+void Renderer::ToggleProgressiveRendering()
+{
+	m_ProgressiveRenderingEnabled = not m_ProgressiveRenderingEnabled;
+
+	std::cout << "[PROGRESSIVE RENDERING]:\t";
+	if (m_ProgressiveRenderingEnabled)
+		std::cout << "ON\n";
+	else
+		std::cout << "OFF\n";
+}
+
+void Renderer::ToggleAdaptiveAntiAliasing()
+{
+	m_AdaptiveAAEnabled = not m_AdaptiveAAEnabled;
+	//The edge buffer only holds the pixels of the frames it was used for
+	m_IsFullyDirty = true;
+
+	//Allocated once, rendering itself never allocates
+	if (m_AdaptiveAAEnabled && m_EdgeBuffer.scores.empty())
+	{
+		const size_t pixelCount{ static_cast<size_t>(m_OutputWidth) * m_OutputHeight };
+		m_EdgeBuffer.materialIndices.resize(pixelCount);
+		m_EdgeBuffer.normalX.resize(pixelCount);
+		m_EdgeBuffer.normalY.resize(pixelCount);
+		m_EdgeBuffer.normalZ.resize(pixelCount);
+		m_EdgeBuffer.scores.resize(pixelCount);
+		m_EdgeBuffer.pixels.reserve(pixelCount);
+	}
+
+	std::cout << "[ADAPTIVE ANTI-ALIASING]:\t";
+	if (m_AdaptiveAAEnabled)
+		std::cout << "ON\n";
+	else
+		std::cout << "OFF\n";
+}
+
+void Renderer::SetAntiAliasingRayBudget(uint32_t rayBudget)
+{
+	m_AntiAliasingRayBudget = rayBudget;
+	m_IsFullyDirty = true;
+}
+
+void Renderer::SetIsaLevel(IsaLevel isaLevel)
+{
+	m_pKernels = &GetKernels(isaLevel);
+	SelectKernels();
+}
+
+void Renderer::SetThreadCount(uint32_t threadCount)
+{
+	//Joins the old workers before the new ones are started
+	m_pThreadPool.reset();
+	m_pThreadPool = std::make_unique<ThreadPool>(threadCount);
+
+	std::cout << "[THREADS]:\t" << m_pThreadPool->GetThreadCount() << "\n";
+}
+
+void Renderer::SetTileSize(uint32_t tileSize)
+{
+	const uint32_t packetCount{ std::max((tileSize + RayPacket::WIDTH - 1) / RayPacket::WIDTH, 1u) };
+	m_TileSize = packetCount * RayPacket::WIDTH;
+
+	m_DirtyTiles.resize(GetTileCount());
+	m_TileIsDirty.resize(GetTileCount());
+	m_TileHitBounds.resize(GetTileCount());
+	m_IsFullyDirty = true;
+}
+
+void Renderer::SetRenderScale(float scale)
+{
+	m_RenderScale = std::clamp(scale, 0.01f, 1.f);
+
+	const int width{ std::max(static_cast<int>(std::round(static_cast<float>(m_OutputWidth) * m_RenderScale)), 1) };
+	const int height{ std::max(static_cast<int>(std::round(static_cast<float>(m_OutputHeight) * m_RenderScale)), 1) };
+	if (width == m_Width && height == m_Height)
+		return;
+
+	//The buffers are sized for the surface, a smaller render resolution reuses them
+	m_Width = width;
+	m_Height = height;
+	m_DirtyTiles.resize(GetTileCount());
+	m_TileIsDirty.resize(GetTileCount());
+	m_TileHitBounds.resize(GetTileCount());
+	//Picks the pack kernel with or without upscaling, the next frame is rendered in full
+	SelectKernels();
+}
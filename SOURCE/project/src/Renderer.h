@@ -1,5 +1,10 @@
 #pragma once
 #include <cstdint>
+#include <memory>
+#include <vector>
+#include "Kernels.h"
+#include "RayStatistics.h"
+#include "ThreadPool.h"
 
 struct SDL_Window;
 struct SDL_Surface;
@@ -8,42 +13,252 @@ namespace dae
 {
 	struct Matrix;
 	struct Vector3;
+	struct HitRecord;
+	struct ColorRGB;
+	struct AABB;
 	class Scene;
+	struct SceneRenderView;
 	class Renderer final
 	{
 	public:
 		Renderer(SDL_Window* pWindow);
-		~Renderer() = default;
+		//Headless: renders into an owned framebuffer, no window needed
+		Renderer(uint32_t width, uint32_t height);
+		~Renderer();
 
 		Renderer(const Renderer&) = delete;
 		Renderer(Renderer&&) noexcept = delete;
 		Renderer& operator=(const Renderer&) = delete;
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
-		void Render(Scene* pScene) const;
-		void RenderPixel(const Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin) const;
-		bool SaveBufferToImage() const;
+		//False when the framebuffer could not be created (SDL_GetError() has the reason), the renderer can't be used then
+		bool IsValid() const { return m_pBuffer != nullptr; }
+
+		void Render(Scene* pScene);
+		//Both return false when the file was written (SDL_SaveBMP convention)
+		bool SaveBufferToImage(const char* filePath = "RayTracing_Buffer.bmp") const;
+		//Raw frame: width * height 32 bit ARGB pixels, row by row, no header
+		bool SaveBufferToRaw(const char* filePath) const;
+
+		//Size of the surface (window), the image is rendered at GetRenderWidth() x GetRenderHeight() and scaled up to it
+		uint32_t GetWidth() const { return static_cast<uint32_t>(m_OutputWidth); }
+		uint32_t GetHeight() const { return static_cast<uint32_t>(m_OutputHeight); }
+		uint32_t GetRenderWidth() const { return static_cast<uint32_t>(m_Width); }
+		uint32_t GetRenderHeight() const { return static_cast<uint32_t>(m_Height); }
+
+		//Renders at a fraction of the surface resolution (per axis, clamped to (0, 1]), the result is scaled up bilinearly
+		void SetRenderScale(float scale);
+		float GetRenderScale() const { return m_RenderScale; }
 
 		void CycleLightingMode();
 		void ToggleShadows();
+		void TogglePacketTracing();
+		//Two passes: closest hits into a G-buffer first, then shading with the pixels grouped per material
+		void ToggleDeferredShading();
+		//Gamma corrects the displayed image through a lookup table, shading itself stays linear
+		void ToggleSRGB();
+		//While the camera and scene don't change, jittered samples are averaged into an anti-aliased image
+		//Rendering stops once MAX_ACCUMULATED_SAMPLES are reached
+		void ToggleProgressiveRendering();
+		//Pixels on edges (material, normal or brightness changes with a neighbour) get stratified extra samples
+		//Only the first sample of a pixel is anti-aliased this way, progressive rendering takes over from there
+		void ToggleAdaptiveAntiAliasing();
+		//Extra rays adaptive anti-aliasing can trace per frame, the strongest edges are supersampled first
+		void SetAntiAliasingRayBudget(uint32_t rayBudget);
+		uint32_t GetAntiAliasingRayBudget() const { return m_AntiAliasingRayBudget; }
+
+		//threadCount includes the main thread, 0 = one thread per hardware thread
+		void SetThreadCount(uint32_t threadCount);
+		uint32_t GetThreadCount() const { return m_pThreadPool->GetThreadCount(); }
+		//Tiles are square, the size is rounded up to a multiple of RayPacket::WIDTH
+		void SetTileSize(uint32_t tileSize);
+		uint32_t GetTileSize() const { return m_TileSize; }
+
+		//Camera rays traced by the last Render (dirty tiles and anti-aliasing samples), shadow rays are not counted
+		uint64_t GetPrimaryRayCount() const { return m_PrimaryRayCount; }
+		//Traversal work of the last Render, only counted in builds with RAY_STATISTICS (all 0 otherwise)
+		const RayStatistics& GetRayStatistics() const { return m_RayStatistics; }
+
+		//Instruction set level of the kernels (see Kernels.h), the highest one the cpu supports by default
+		void SetIsaLevel(IsaLevel isaLevel);
+		IsaLevel GetIsaLevel() const { return m_pKernels->isaLevel; }
 	private:
-		enum class LightingMode
-		{
-			ObservedArea, //Lambert Cosine Law
-			Radiance, //Incident Radiance
-			BRDF, //Scattering of the light
-			Combined //ObservedArea * Radiance * BRDF
-		};
+		const Kernels* m_pKernels{ &GetKernels(GetSupportedIsaLevel()) };
 
 		LightingMode m_CurrentLightingMode{ LightingMode::Combined };
 		bool m_ShadowsEnabled{ true };
 
+		//The tile kernel is compiled for every lighting mode and shadow setting, changing a setting selects another one
+		//This keeps the per pixel/per light loop free of mode switches
+		using RenderTileKernel = void (Renderer::*)(const SceneRenderView& view, uint32_t tileIndex, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin);
+		RenderTileKernel m_pRenderTileKernel{};
+		//Forward shading of a hit, the shading pass of deferred shading and the conversion of the HDR buffer to the surface, from m_pKernels
+		ShadeHitKernel m_pShadeHitKernel{};
+		ShadeSamplesKernel m_pShadeSamplesKernel{};
+		ToneMapKernel m_pToneMapKernel{};
+		//Adaptive anti-aliasing, shades the extra samples of a chunk of the edge pixels
+		using SupersampleChunkKernel = void (Renderer::*)(const SceneRenderView& view, uint32_t chunkIndex, uint32_t samplesPerAxis, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin);
+		SupersampleChunkKernel m_pSupersampleChunkKernel{};
+
+		//One entry per pixel (SoA), only allocated once deferred shading is enabled
+		struct GBuffer final
+		{
+			static constexpr uint16_t MISS{ UINT16_MAX };
+
+			std::vector<float> t{};
+			std::vector<float> normalX{};
+			std::vector<float> normalY{};
+			std::vector<float> normalZ{};
+			std::vector<uint16_t> materialIndices{};
+
+			//Pixels that hit something, sorted by material between the two passes
+			std::vector<uint32_t> shadeOrder{};
+		};
+		GBuffer m_GBuffer{};
+		bool m_PacketTracingEnabled{ true };
+		bool m_DeferredShadingEnabled{ false };
+		bool m_SRGBEnabled{ false };
+
+		//Linear color per pixel (SoA), shading writes here and ToneMapAndPack converts it to the surface format
+		//Padded to a multiple of SIMD::MAX_WIDTH pixels
+		struct HDRBuffer final
+		{
+			std::vector<float> red{};
+			std::vector<float> green{};
+			std::vector<float> blue{};
+		};
+		HDRBuffer m_HDRBuffer{};
+
+		//Progressive rendering: the HDR buffer holds the sum of m_AccumulatedSampleCount samples
+		static constexpr uint32_t MAX_ACCUMULATED_SAMPLES{ 256 };
+		bool m_ProgressiveRenderingEnabled{ false };
+		uint32_t m_AccumulatedSampleCount{};
+
+		//Adaptive anti-aliasing: what the first sample of every pixel hit, only allocated once it is enabled
+		struct EdgeBuffer final
+		{
+			static constexpr uint16_t MISS{ UINT16_MAX };
+
+			std::vector<uint16_t> materialIndices{};
+			std::vector<float> normalX{};
+			std::vector<float> normalY{};
+			std::vector<float> normalZ{};
+			//0 when the pixel is not on an edge, higher for stronger edges
+			std::vector<float> scores{};
+
+			//Edge pixels of the dirty tiles that fit in the ray budget
+			std::vector<uint32_t> pixels{};
+		};
+		EdgeBuffer m_EdgeBuffer{};
+		bool m_AdaptiveAAEnabled{ false };
+		uint32_t m_AntiAliasingRayBudget{ 65536 };
+
+		//Dirty tracking: frames without changes are skipped, when only meshes moved just the tiles they affect are traced again
+		//A setting change or another scene redraws everything
+		bool m_IsFullyDirty{ true };
+		const Scene* m_pRenderedScene{};
+		//Bounds of the surface points the primary rays of a tile hit (empty when they all missed), used to find the shadows of moved meshes
+		std::vector<AABB> m_TileHitBounds{};
+		//Tiles traced this frame, m_DirtyTiles[0, m_DirtyTileCount)
+		std::vector<uint32_t> m_DirtyTiles{};
+		std::vector<uint8_t> m_TileIsDirty{};
+		uint32_t m_DirtyTileCount{};
+		uint64_t m_PrimaryRayCount{};
+		RayStatistics m_RayStatistics{};
+		//Tests per pixel for the Cost lighting mode, only allocated with RAY_STATISTICS
+		//Packets split their shared traversal evenly over their rays
+		std::vector<uint32_t> m_PixelCosts{};
+		//Position of the primary rays inside their pixel, the center unless progressive rendering jitters it
+		float m_SampleOffsetX{ 0.5f };
+		float m_SampleOffsetY{ 0.5f };
+
+		std::unique_ptr<ThreadPool> m_pThreadPool{};
+		uint32_t m_TileSize{ 32 };
+
 		SDL_Window* m_pWindow{};
 
 		SDL_Surface* m_pBuffer{};
 		uint32_t* m_pBufferPixels{};
+		//Pixels per surface row, rows can be padded so this can be more than the width
+		uint32_t m_BufferRowStride{};
+		bool m_OwnsBuffer{};
+
+		//Channel positions of the 32 bit surface format, pixels are packed without SDL_MapRGB
+		uint32_t m_RedShift{};
+		uint32_t m_GreenShift{};
+		uint32_t m_BlueShift{};
+		uint32_t m_AlphaMask{};
 
+		//Render resolution, m_RenderScale times the surface resolution
 		int m_Width{};
 		int m_Height{};
+		int m_OutputWidth{};
+		int m_OutputHeight{};
+		float m_RenderScale{ 1.f };
+
+		void InitializeBuffers();
+		void SelectKernels();
+
+		//Pixels [firstX, endX) x [firstY, endY)
+		struct PixelRect final
+		{
+			uint32_t firstX, firstY, endX, endY;
+
+			bool Overlaps(const PixelRect& other) const { return firstX < other.endX && other.firstX < endX && firstY < other.endY && other.firstY < endY; }
+		};
+		//Screen rects of the moved meshes, refilled every frame with partial changes
+		std::vector<PixelRect> m_DirtyRects{};
+		uint32_t GetTileCount() const;
+		PixelRect GetTileRect(uint32_t tileIndex) const;
+		//Screen area the box can cover, the whole screen when part of it is behind the camera
+		PixelRect GetScreenRect(const AABB& bounds, float fov, float aspectRatio, const Matrix& worldToCamera) const;
+
+		void SelectAllTiles();
+		//Tiles the moved meshes covered or cover now, or that can be in their old or new shadow
+		void SelectDirtyTiles(const SceneRenderView& view, const std::vector<AABB>& dirtyBounds, float fov, float aspectRatio, const Matrix& cameraToWorld);
+		bool IsTileDirty(const SceneRenderView& view, uint32_t tileIndex, const std::vector<AABB>& dirtyBounds) const;
+
+		//Traces the primary rays of one screen tile, per packet or per pixel depending on the packet tracing setting
+		//onHit(px, py, closestHit, rayDirection) is called for every pixel
+		template<typename HitFunction>
+		void TraceTile(const SceneRenderView& view, uint32_t tileIndex, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const HitFunction& onHit);
+		template<typename HitFunction>
+		void TracePixel(const SceneRenderView& view, uint32_t px, uint32_t py, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const HitFunction& onHit);
+		//Traces a block of up to RayPacket::WIDTH x RayPacket::WIDTH pixels, starting at (firstX, firstY), as one packet
+		template<typename HitFunction>
+		void TracePacket(const SceneRenderView& view, uint32_t firstX, uint32_t firstY, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin, const HitFunction& onHit);
+
+		Vector3 GetViewDirection(uint32_t px, uint32_t py, float fov, float aspectRatio, const Matrix& cameraToWorld) const;
+		//Direction through a point of the screen, in pixels from the top left corner
+		Vector3 GetSampleDirection(float screenX, float screenY, float fov, float aspectRatio, const Matrix& cameraToWorld) const;
+		//Stores the linear color in the HDR buffer, adds it when samples are being accumulated
+		void WritePixel(uint32_t pixelIndex, const ColorRGB& color);
+		//Tonemaps (MaxToOne) the HDR buffer and writes it to the surface, one chunk of surface pixels per call
+		void ToneMapAndPack(uint32_t chunkIndex);
+
+		//Forward shading
+		template<LightingMode lightingMode, bool shadowsEnabled>
+		void RenderTile(const SceneRenderView& view, uint32_t tileIndex, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin);
+		template<LightingMode lightingMode, bool shadowsEnabled>
+		void ShadePixel(const SceneRenderView& view, uint32_t px, uint32_t py, const HitRecord& closestHit, const Vector3& viewDirection);
+
+		//Deferred shading
+		void RenderGBufferTile(const SceneRenderView& view, uint32_t tileIndex, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin);
+		void WriteGBuffer(uint32_t px, uint32_t py, const HitRecord& closestHit);
+		//Sorts the hit pixels of the dirty tiles, returns the amount of pixels that hit something
+		uint32_t SortGBufferByMaterial();
+		//Works on a chunk of the material sorted hit pixels
+		void ShadeChunk(const SceneRenderView& view, uint32_t chunkIndex, uint32_t hitCount, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin);
+		//Shades up to the kernel width of pixels with the same material at once
+		void ShadeGroup(const SceneRenderView& view, const uint32_t* pPixelIndices, uint32_t count, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin);
+
+		//Adaptive anti-aliasing
+		void WriteEdgeBuffer(uint32_t pixelIndex, const HitRecord& closestHit);
+		//Scores the pixels of a tile against their 4 neighbours
+		void DetectEdges(uint32_t tileIndex);
+		//Collects the edge pixels of the dirty tiles that fit in the ray budget, returns the samples per axis they get (0 = none)
+		uint32_t SelectEdgePixels();
+		template<LightingMode lightingMode, bool shadowsEnabled>
+		void SupersampleChunk(const SceneRenderView& view, uint32_t chunkIndex, uint32_t samplesPerAxis, float fov, float aspectRatio, const Matrix& cameraToWorld, const Vector3& cameraOrigin);
 	};
 }
@@ -0,0 +1,164 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include "Math.h"
+
+#include "SIMDConfig.h"
+
+namespace dae
+{
+	namespace SIMD
+	{
+#pragma region Float4
+		//4 floats processed at once, falls back to plain floats when SSE is not available
+		//Comparisons return masks (all bits set per lane) that can be combined with & and |
+		struct Float4 final
+		{
+#if defined(SIMD_SSE)
+			__m128 value;
+
+			static Float4 Broadcast(float f) { return { _mm_set1_ps(f) }; }
+			static Float4 Load(const float* pData) { return { _mm_loadu_ps(pData) }; }
+			void Store(float* pData) const { _mm_storeu_ps(pData, value); }
+			//Converts to integers, rounding towards zero like static_cast
+			void StoreTruncated(int32_t* pData) const { _mm_storeu_si128(reinterpret_cast<__m128i*>(pData), _mm_cvttps_epi32(value)); }
+
+			friend Float4 operator-(Float4 a) { return { _mm_xor_ps(a.value, _mm_set1_ps(-0.f)) }; }
+			friend Float4 operator+(Float4 a, Float4 b) { return { _mm_add_ps(a.value, b.value) }; }
+			friend Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.value, b.value) }; }
+			friend Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.value, b.value) }; }
+			friend Float4 operator/(Float4 a, Float4 b) { return { _mm_div_ps(a.value, b.value) }; }
+			friend Float4 operator<(Float4 a, Float4 b) { return { _mm_cmplt_ps(a.value, b.value) }; }
+			friend Float4 operator<=(Float4 a, Float4 b) { return { _mm_cmple_ps(a.value, b.value) }; }
+			friend Float4 operator>(Float4 a, Float4 b) { return { _mm_cmpgt_ps(a.value, b.value) }; }
+			friend Float4 operator>=(Float4 a, Float4 b) { return { _mm_cmpge_ps(a.value, b.value) }; }
+			friend Float4 operator==(Float4 a, Float4 b) { return { _mm_cmpeq_ps(a.value, b.value) }; }
+			friend Float4 operator&(Float4 a, Float4 b) { return { _mm_and_ps(a.value, b.value) }; }
+			friend Float4 operator|(Float4 a, Float4 b) { return { _mm_or_ps(a.value, b.value) }; }
+
+			static Float4 Min(Float4 a, Float4 b) { return { _mm_min_ps(a.value, b.value) }; }
+			static Float4 Max(Float4 a, Float4 b) { return { _mm_max_ps(a.value, b.value) }; }
+			static Float4 Abs(Float4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.f), a.value) }; }
+			static Float4 Sqrt(Float4 a) { return { _mm_sqrt_ps(a.value) }; }
+			//Per lane: mask ? a : b
+			static Float4 Select(Float4 mask, Float4 a, Float4 b) { return { _mm_or_ps(_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value)) }; }
+			//One bit per lane, set when the lane of the mask is set
+			static int MoveMask(Float4 mask) { return _mm_movemask_ps(mask.value); }
+
+			static float HorizontalMin(Float4 a)
+			{
+				const __m128 halves{ _mm_min_ps(a.value, _mm_movehl_ps(a.value, a.value)) };
+				return _mm_cvtss_f32(_mm_min_ss(halves, _mm_shuffle_ps(halves, halves, _MM_SHUFFLE(1, 1, 1, 1))));
+			}
+#else
+			float value[4];
+
+			static Float4 Broadcast(float f) { return { { f, f, f, f } }; }
+			static Float4 Load(const float* pData) { return { { pData[0], pData[1], pData[2], pData[3] } }; }
+			void Store(float* pData) const { std::copy(value, value + 4, pData); }
+			void StoreTruncated(int32_t* pData) const { for (int lane{}; lane < 4; ++lane) pData[lane] = static_cast<int32_t>(value[lane]); }
+
+			template<typename Operation>
+			static Float4 PerLane(Float4 a, Float4 b, Operation operation)
+			{
+				Float4 result;
+				for (int lane{}; lane < 4; ++lane) result.value[lane] = operation(a.value[lane], b.value[lane]);
+				return result;
+			}
+			static float ToMask(bool condition) { return std::bit_cast<float>(condition ? 0xFFFFFFFFu : 0u); }
+			static uint32_t ToBits(float f) { return std::bit_cast<uint32_t>(f); }
+
+			friend Float4 operator-(Float4 a) { return PerLane(a, a, [](float x, float) { return -x; }); }
+			friend Float4 operator+(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return x + y; }); }
+			friend Float4 operator-(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return x - y; }); }
+			friend Float4 operator*(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return x * y; }); }
+			friend Float4 operator/(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return x / y; }); }
+			friend Float4 operator<(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return ToMask(x < y); }); }
+			friend Float4 operator<=(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return ToMask(x <= y); }); }
+			friend Float4 operator>(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return ToMask(x > y); }); }
+			friend Float4 operator>=(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return ToMask(x >= y); }); }
+			friend Float4 operator==(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return ToMask(x == y); }); }
+			friend Float4 operator&(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return std::bit_cast<float>(ToBits(x) & ToBits(y)); }); }
+			friend Float4 operator|(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return std::bit_cast<float>(ToBits(x) | ToBits(y)); }); }
+
+			static Float4 Min(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return x < y ? x : y; }); }
+			static Float4 Max(Float4 a, Float4 b) { return PerLane(a, b, [](float x, float y) { return x > y ? x : y; }); }
+			static Float4 Abs(Float4 a) { return PerLane(a, a, [](float x, float) { return std::bit_cast<float>(ToBits(x) & 0x7FFFFFFFu); }); }
+			static Float4 Sqrt(Float4 a) { return PerLane(a, a, [](float x, float) { return std::sqrt(x); }); }
+			static Float4 Select(Float4 mask, Float4 a, Float4 b)
+			{
+				Float4 result;
+				for (int lane{}; lane < 4; ++lane) result.value[lane] = ToBits(mask.value[lane]) ? a.value[lane] : b.value[lane];
+				return result;
+			}
+			static int MoveMask(Float4 mask)
+			{
+				int bits{};
+				for (int lane{}; lane < 4; ++lane) bits |= static_cast<int>(ToBits(mask.value[lane]) >> 31) << lane;
+				return bits;
+			}
+
+			static float HorizontalMin(Float4 a)
+			{
+				return std::min(std::min(a.value[0], a.value[1]), std::min(a.value[2], a.value[3]));
+			}
+#endif
+		};
+#pragma endregion
+#pragma region Float8
+#if defined(SIMD_SSE)
+		//8 floats processed at once, only used by the AVX2 kernels (see Kernels.h)
+SIMD_TARGET_BEGIN(SIMD_TARGETS_AVX2)
+		struct Float8 final
+		{
+			__m256 value;
+
+			static Float8 Broadcast(float f) { return { _mm256_set1_ps(f) }; }
+			static Float8 Load(const float* pData) { return { _mm256_loadu_ps(pData) }; }
+			void Store(float* pData) const { _mm256_storeu_ps(pData, value); }
+			void StoreTruncated(int32_t* pData) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(pData), _mm256_cvttps_epi32(value)); }
+
+			static Float8 Min(Float8 a, Float8 b) { return { _mm256_min_ps(a.value, b.value) }; }
+			static Float8 Max(Float8 a, Float8 b) { return { _mm256_max_ps(a.value, b.value) }; }
+			static Float8 Abs(Float8 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.value) }; }
+			static Float8 Sqrt(Float8 a) { return { _mm256_sqrt_ps(a.value) }; }
+			static Float8 Select(Float8 mask, Float8 a, Float8 b) { return { _mm256_blendv_ps(b.value, a.value, mask.value) }; }
+			static int MoveMask(Float8 mask) { return _mm256_movemask_ps(mask.value); }
+
+			static float HorizontalMin(Float8 a)
+			{
+				const Float4 halves{ _mm_min_ps(_mm256_castps256_ps128(a.value), _mm256_extractf128_ps(a.value, 1)) };
+				return Float4::HorizontalMin(halves);
+			}
+		};
+
+		//Not friends, GCC does not apply the target pragma to friend functions defined in the class
+		inline Float8 operator-(Float8 a) { return { _mm256_xor_ps(a.value, _mm256_set1_ps(-0.f)) }; }
+
+		inline Float8 operator+(Float8 a, Float8 b) { return { _mm256_add_ps(a.value, b.value) }; }
+		inline Float8 operator-(Float8 a, Float8 b) { return { _mm256_sub_ps(a.value, b.value) }; }
+		inline Float8 operator*(Float8 a, Float8 b) { return { _mm256_mul_ps(a.value, b.value) }; }
+		inline Float8 operator/(Float8 a, Float8 b) { return { _mm256_div_ps(a.value, b.value) }; }
+		inline Float8 operator<(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_LT_OQ) }; }
+		inline Float8 operator<=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_LE_OQ) }; }
+		inline Float8 operator>(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ) }; }
+		inline Float8 operator>=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_GE_OQ) }; }
+		inline Float8 operator==(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_EQ_OQ) }; }
+		inline Float8 operator&(Float8 a, Float8 b) { return { _mm256_and_ps(a.value, b.value) }; }
+		inline Float8 operator|(Float8 a, Float8 b) { return { _mm256_or_ps(a.value, b.value) }; }
+SIMD_TARGET_END
+#endif
+#pragma endregion
+
+		//Widest type of all kernel levels, data the kernels load from is padded and sized for it
+		constexpr uint32_t MAX_WIDTH{ 8 };
+
+		//Index of the lowest set bit
+		inline int GetFirstSetLane(int bits)
+		{
+			return std::countr_zero(static_cast<uint32_t>(bits));
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+//SSE2 is part of every x64 cpu, wider instruction sets are only used inside target regions (see Kernels.h)
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+	#define SIMD_SSE
+	#include <immintrin.h>
+#endif
+
+//Instruction sets of the kernel levels, IsaLevel in CpuFeatures.h
+#define SIMD_TARGETS_SSE4 "sse4.2,popcnt"
+#define SIMD_TARGETS_AVX2 "avx2,fma"
+
+//Functions defined between SIMD_TARGET_BEGIN(targets) and SIMD_TARGET_END are compiled for those instruction sets,
+//everything else in the translation unit stays at the baseline, so inline functions the units share are the same everywhere
+//Only include headers before the region, a header included inside it would compile its inline functions for the targets
+//MSVC compiles intrinsics of every instruction set without flags, the regions are empty there
+#define SIMD_PRAGMA(...) _Pragma(#__VA_ARGS__)
+#if defined(SIMD_SSE) && defined(__clang__)
+	#define SIMD_TARGET_BEGIN(targets) SIMD_PRAGMA(clang attribute push(__attribute__((target(targets))), apply_to = function))
+	#define SIMD_TARGET_END SIMD_PRAGMA(clang attribute pop)
+#elif defined(SIMD_SSE) && defined(__GNUC__)
+	#define SIMD_TARGET_BEGIN(targets) SIMD_PRAGMA(GCC push_options) SIMD_PRAGMA(GCC target(targets))
+	#define SIMD_TARGET_END SIMD_PRAGMA(GCC pop_options)
+#else
+	#define SIMD_TARGET_BEGIN(targets)
+	#define SIMD_TARGET_END
+#endif
@@ -2,12 +2,15 @@
 #include "Utils.h"
 #include "Material.h"
 
+#include <algorithm>
+#include <iostream>
+
 namespace dae {
 
 #pragma region Base Scene
 	//Initialize Scene with Default Solid Color Material (RED)
 	Scene::Scene() :
-		m_Materials({ new Material_SolidColor({1,0,0}) })
+		m_Materials({ Material_SolidColor{ {1,0,0} } })
 	{
 		m_SphereGeometries.reserve(32);
 		m_PlaneGeometries.reserve(32);
@@ -15,52 +18,125 @@ namespace dae {
 		m_Lights.reserve(32);
 	}
 
-	Scene::~Scene()
+	Scene::~Scene() = default;
+
+	void Scene::ToggleAnimation()
 	{
-		for (auto& pMaterial : m_Materials)
-		{
-			delete pMaterial;
-			pMaterial = nullptr;
-		}
+		m_IsAnimating = not m_IsAnimating;
 
-		m_Materials.clear();
+		std::cout << "[ANIMATION]:\t";
+		if (m_IsAnimating)
+			std::cout << "ON\n";
+		else
+			std::cout << "OFF\n";
 	}
 
-	void dae::Scene::GetClosestHit(const Ray& ray, HitRecord& closestHit) const
+	void Scene::UpdateAccelerationStructure()
 	{
-		for (const auto& sphere : m_SphereGeometries)
+		//Planes are few and cheap to pack, so their blocks are always refilled
+		m_PlaneBlocks.clear();
+		for (uint32_t planeIndex{}; planeIndex < m_PlaneGeometries.size(); ++planeIndex)
 		{
-			GeometryUtils::HitTest_Sphere(sphere, ray, closestHit);
+			const uint32_t lane{ planeIndex % PRIMITIVE_BLOCK_WIDTH };
+			if (lane == 0) m_PlaneBlocks.emplace_back();
+
+			m_PlaneBlocks.back().SetLane(lane, m_PlaneGeometries[planeIndex], planeIndex);
 		}
-		for (const auto& plane : m_PlaneGeometries)
+
+		//Returns true when the bounds are different from last update
+		const auto updateBounds = [](AABB& bounds, const Vector3& min, const Vector3& max)
 		{
-			GeometryUtils::HitTest_Plane(plane, ray, closestHit);
-		}
-		for (const auto& mesh: m_TriangleMeshGeometries)
+			if (bounds.min == min && bounds.max == max) return false;
+
+			bounds.min = min;
+			bounds.max = max;
+			return true;
+		};
+
+		//Only update when an object was added, removed or moved since the last update
+		const size_t sphereCount{ m_SphereGeometries.size() };
+		bool spheresChanged{ m_SphereBounds.size() != sphereCount };
+		m_SphereBounds.resize(sphereCount);
+		for (size_t sphereIndex{}; sphereIndex < sphereCount; ++sphereIndex)
 		{
-			GeometryUtils::HitTest_TriangleMesh(mesh, ray, closestHit);
+			const Sphere& sphere{ m_SphereGeometries[sphereIndex] };
+			const Vector3 extent{ sphere.radius, sphere.radius, sphere.radius };
+			spheresChanged |= updateBounds(m_SphereBounds[sphereIndex], sphere.origin - extent, sphere.origin + extent);
 		}
-	}
 
-	bool Scene::DoesHit(const Ray& ray) const
-	{
-		for (const auto& sphere : m_SphereGeometries)
+		const size_t meshCount{ m_TriangleMeshGeometries.size() };
+		//New meshes were never rendered, so their old bounds are unknown
+		const bool meshesAdded{ m_MeshBounds.size() != meshCount };
+		bool meshesChanged{ meshesAdded };
+		m_MeshBounds.resize(meshCount);
+		m_MeshTransformVersions.resize(meshCount);
+		m_Changes.dirtyMeshBounds.clear();
+		for (size_t meshIndex{}; meshIndex < meshCount; ++meshIndex)
 		{
-			if (GeometryUtils::HitTest_Sphere(sphere, ray))
-				return true;
+			TriangleMesh& mesh{ m_TriangleMeshGeometries[meshIndex] };
+			//Instances are not told when the shared geometry changed through another instance
+			mesh.UpdateTransforms();
+
+			const AABB previousBounds{ m_MeshBounds[meshIndex] };
+			meshesChanged |= updateBounds(m_MeshBounds[meshIndex], mesh.transformedMinAABB, mesh.transformedMaxAABB);
+
+			//A moved mesh affects the pixels it covered and the pixels it covers now
+			if (m_MeshTransformVersions[meshIndex] != mesh.transformVersion)
+			{
+				m_MeshTransformVersions[meshIndex] = mesh.transformVersion;
+				m_Changes.dirtyMeshBounds.push_back(previousBounds);
+				m_Changes.dirtyMeshBounds.push_back(AABB{ mesh.transformedMinAABB, mesh.transformedMaxAABB });
+			}
 		}
-		for (const auto& plane : m_PlaneGeometries)
+
+		//Everything else is cheap to compare but can affect any pixel
+		const auto isSameLight = [](const Light& a, const Light& b)
 		{
-			if (GeometryUtils::HitTest_Plane(plane, ray))
-				return true;
-		}
-		for (const auto& mesh: m_TriangleMeshGeometries)
+			return a.origin == b.origin && a.direction == b.direction && a.intensity == b.intensity && a.type == b.type
+				&& a.color.r == b.color.r && a.color.g == b.color.g && a.color.b == b.color.b;
+		};
+		const auto isSamePlane = [](const Plane& a, const Plane& b)
+		{
+			return a.origin == b.origin && a.normal == b.normal && a.materialIndex == b.materialIndex;
+		};
+		const bool lightsChanged{ !std::equal(m_Lights.begin(), m_Lights.end(), m_PreviousLights.begin(), m_PreviousLights.end(), isSameLight) };
+		const bool planesChanged{ !std::equal(m_PlaneGeometries.begin(), m_PlaneGeometries.end(), m_PreviousPlanes.begin(), m_PreviousPlanes.end(), isSamePlane) };
+		if (lightsChanged)
+			m_PreviousLights = m_Lights;
+		if (planesChanged)
+			m_PreviousPlanes = m_PlaneGeometries;
+
+		m_Changes.isFullyDirty = m_HasCameraMoved || spheresChanged || meshesAdded || lightsChanged || planesChanged;
+		m_HasCameraMoved = false;
+
+		//Refit falls back to a full build when objects were added/removed or the tree quality degraded
+		if (spheresChanged)
 		{
-			if (GeometryUtils::HitTest_TriangleMesh(mesh, ray))
-				return true;
+			if (m_SphereBVH.IsEmpty())
+				m_SphereBVH.Build(m_SphereBounds, PRIMITIVE_BLOCK_WIDTH);
+			else
+				m_SphereBVH.Refit(m_SphereBounds);
+
+			BuildLeafBlocks(m_SphereBVH, PRIMITIVE_BLOCK_WIDTH, m_SphereBlocks, m_SphereLeafFirstBlock, [&](SphereBlock& block, uint32_t lane, uint32_t sphereIndex)
+			{
+				block.SetLane(lane, m_SphereGeometries[sphereIndex], sphereIndex);
+			});
 		}
 
-		return false;
+		if (meshesChanged)
+			m_MeshBVH.Refit(m_MeshBounds);
+
+		//The containers can have grown since the last frame
+		m_RenderView.materials = m_Materials;
+		m_RenderView.lights = m_Lights;
+		m_RenderView.planes = m_PlaneGeometries;
+		m_RenderView.spheres = m_SphereGeometries;
+		m_RenderView.triangleMeshes = m_TriangleMeshGeometries;
+		m_RenderView.planeBlocks = m_PlaneBlocks;
+		m_RenderView.pSphereBVH = &m_SphereBVH;
+		m_RenderView.sphereBlocks = m_SphereBlocks;
+		m_RenderView.sphereLeafFirstBlock = m_SphereLeafFirstBlock;
+		m_RenderView.pMeshBVH = &m_MeshBVH;
 	}
 
 #pragma region Scene Helpers
@@ -86,14 +162,24 @@ namespace dae {
 		return &m_PlaneGeometries.back();
 	}
 
-	TriangleMesh* Scene::AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex)
+	uint32_t Scene::AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex)
 	{
 		TriangleMesh m{};
 		m.cullMode = cullMode;
 		m.materialIndex = materialIndex;
 
 		m_TriangleMeshGeometries.emplace_back(m);
-		return &m_TriangleMeshGeometries.back();
+		return static_cast<uint32_t>(m_TriangleMeshGeometries.size() - 1);
+	}
+
+	uint32_t Scene::AddTriangleMeshInstance(uint32_t sourceMeshIndex, unsigned char materialIndex)
+	{
+		//Copies only the transforms, geometry and BVH are shared with the source mesh
+		TriangleMesh m{ m_TriangleMeshGeometries[sourceMeshIndex] };
+		m.materialIndex = materialIndex;
+
+		m_TriangleMeshGeometries.emplace_back(m);
+		return static_cast<uint32_t>(m_TriangleMeshGeometries.size() - 1);
 	}
 
 	Light* Scene::AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color)
@@ -120,9 +206,9 @@ namespace dae {
 		return &m_Lights.back();
 	}
 
-	unsigned char Scene::AddMaterial(Material* pMaterial)
+	unsigned char Scene::AddMaterial(const Material& material)
 	{
-		m_Materials.push_back(pMaterial);
+		m_Materials.push_back(material);
 		return static_cast<unsigned char>(m_Materials.size() - 1);
 	}
 #pragma endregion
@@ -134,15 +220,15 @@ namespace dae {
 		m_Camera.origin = { 0.f,3.f,-9.f };
 		m_Camera.fovAngle = 45.f;
 
-		const auto matCT_GrayRoughMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 1.f));
-		const auto matCT_GrayMediumMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 0.6f));
-		const auto matCT_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, .1f));
-		const auto matCT_GrayRoughPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f));
-		const auto matCT_GrayMediumPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f));
-		const auto matCT_GraySmoothPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, .1f));
+		const auto matCT_GrayRoughMetal = AddMaterial(Material_CookTorrence{ { 0.972f, 0.960f, 0.915f }, 1.f, 1.f });
+		const auto matCT_GrayMediumMetal = AddMaterial(Material_CookTorrence{ { 0.972f, 0.960f, 0.915f }, 1.f, 0.6f });
+		const auto matCT_GraySmoothMetal = AddMaterial(Material_CookTorrence{ { 0.972f, 0.960f, 0.915f }, 1.f, .1f });
+		const auto matCT_GrayRoughPlastic = AddMaterial(Material_CookTorrence{ { 0.75f, 0.75f, 0.75f }, 0.f, 1.f });
+		const auto matCT_GrayMediumPlastic = AddMaterial(Material_CookTorrence{ { 0.75f, 0.75f, 0.75f }, 0.f, 0.6f });
+		const auto matCT_GraySmoothPlastic = AddMaterial(Material_CookTorrence{ { 0.75f, 0.75f, 0.75f }, 0.f, .1f });
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.f));
+		const auto matLambert_GrayBlue = AddMaterial(Material_Lambert{ { 0.49f, 0.57f, 0.57f }, 1.f });
+		const auto matLambert_White = AddMaterial(Material_Lambert{ colors::White, 1.f });
 
 		//Planes
 		AddPlane(Vector3{ 0.f,0.f,10.f }, Vector3{ 0.f,0.f,-1.f }, matLambert_GrayBlue);
@@ -164,23 +250,32 @@ namespace dae {
 		//CW Winding Order!
 		const Triangle baseTriangle = { Vector3(-0.75f,1.5f,0.f), Vector3(0.75f,0.f,0.f), Vector3(-0.75f,0.f,0.f) };
 
-		m_Meshes[0] = AddTriangleMesh(TriangleCullMode::BackFaceCulling, matLambert_White);
-		m_Meshes[0]->AppendTriangle(baseTriangle, true);
-		m_Meshes[0]->Translate({ -1.75f,4.5f,0.f });
-		m_Meshes[0]->UpdateAABB();
-		m_Meshes[0]->UpdateTransforms();
+		m_MeshIndices[0] = AddTriangleMesh(TriangleCullMode::BackFaceCulling, matLambert_White);
+		{
+			TriangleMesh& mesh{ m_TriangleMeshGeometries[m_MeshIndices[0]] };
+			mesh.AppendTriangle(baseTriangle, true);
+			mesh.Translate({ -1.75f,4.5f,0.f });
+			mesh.UpdateAABB();
+			mesh.UpdateTransforms();
+		}
 
-		m_Meshes[1] = AddTriangleMesh(TriangleCullMode::FrontFaceCulling, matLambert_White);
-		m_Meshes[1]->AppendTriangle(baseTriangle, true);
-		m_Meshes[1]->Translate({ 0.f,4.5f,0.f });
-		m_Meshes[1]->UpdateAABB();
-		m_Meshes[1]->UpdateTransforms();
+		m_MeshIndices[1] = AddTriangleMesh(TriangleCullMode::FrontFaceCulling, matLambert_White);
+		{
+			TriangleMesh& mesh{ m_TriangleMeshGeometries[m_MeshIndices[1]] };
+			mesh.AppendTriangle(baseTriangle, true);
+			mesh.Translate({ 0.f,4.5f,0.f });
+			mesh.UpdateAABB();
+			mesh.UpdateTransforms();
+		}
 
-		m_Meshes[2] = AddTriangleMesh(TriangleCullMode::NoCulling, matLambert_White);
-		m_Meshes[2]->AppendTriangle(baseTriangle, true);
-		m_Meshes[2]->Translate({ 1.75f,4.5f,0.f });
-		m_Meshes[2]->UpdateAABB();
-		m_Meshes[2]->UpdateTransforms();
+		m_MeshIndices[2] = AddTriangleMesh(TriangleCullMode::NoCulling, matLambert_White);
+		{
+			TriangleMesh& mesh{ m_TriangleMeshGeometries[m_MeshIndices[2]] };
+			mesh.AppendTriangle(baseTriangle, true);
+			mesh.Translate({ 1.75f,4.5f,0.f });
+			mesh.UpdateAABB();
+			mesh.UpdateTransforms();
+		}
 
 
 		//Lights
@@ -192,12 +287,15 @@ namespace dae {
 	void Scene_Reference::Update(Timer* pTimer)
 	{
 		Scene::Update(pTimer);
+		if (!m_IsAnimating)
+			return;
 
 		const auto yawAngle = (cos(pTimer->GetTotal()) + 1.f) / 2.f * PI_2;
-		for (const auto m : m_Meshes)
+		for (const uint32_t meshIndex : m_MeshIndices)
 		{
-			m->RotateY(yawAngle);
-			m->UpdateTransforms();
+			TriangleMesh& mesh{ m_TriangleMeshGeometries[meshIndex] };
+			mesh.RotateY(yawAngle);
+			mesh.UpdateTransforms();
 		}
 	}
 #pragma endregion
@@ -208,8 +306,8 @@ namespace dae {
 		m_Camera.origin = { 0.f,3.f,-9.f };
 		m_Camera.fovAngle = 45.f;
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.f));
+		const auto matLambert_GrayBlue = AddMaterial(Material_Lambert{ { 0.49f, 0.57f, 0.57f }, 1.f });
+		const auto matLambert_White = AddMaterial(Material_Lambert{ colors::White, 1.f });
 
 		//Planes
 		AddPlane(Vector3{ 0.f,0.f,10.f }, Vector3{ 0.f,0.f,-1.f }, matLambert_GrayBlue);
@@ -219,15 +317,16 @@ namespace dae {
 		AddPlane(Vector3{ -5.f,0.f,0.f }, Vector3{ 1.f,0.f,0.f }, matLambert_GrayBlue);
 
 		//Bunny obj
-		m_pBunnyMesh = AddTriangleMesh(TriangleCullMode::BackFaceCulling, matLambert_White);
+		m_BunnyMeshIndex = AddTriangleMesh(TriangleCullMode::BackFaceCulling, matLambert_White);
+		TriangleMesh& bunnyMesh{ m_TriangleMeshGeometries[m_BunnyMeshIndex] };
 		Utils::ParseOBJ("Resources/lowpoly_bunny.obj",
-			m_pBunnyMesh->positions,
-			m_pBunnyMesh->normals,
-			m_pBunnyMesh->indices);
-		m_pBunnyMesh->Scale({ 2.f,2.f,2.f });
-		m_pBunnyMesh->RotateY(PI);
-		m_pBunnyMesh->UpdateAABB();
-		m_pBunnyMesh->UpdateTransforms();
+			bunnyMesh.pData->positions,
+			bunnyMesh.pData->normals,
+			bunnyMesh.pData->indices);
+		bunnyMesh.Scale({ 2.f,2.f,2.f });
+		bunnyMesh.RotateY(PI);
+		bunnyMesh.UpdateAABB();
+		bunnyMesh.UpdateTransforms();
 
 		//Lights
 		AddPointLight(Vector3{ 0.f, 5.f, 5.f }, 50.f, ColorRGB{ 1.f, 0.61f, 0.45f }); // Backlight
@@ -239,10 +338,129 @@ namespace dae {
 	void Scene_Bunny::Update(Timer* pTimer)
 	{
 		Scene::Update(pTimer);
+		if (!m_IsAnimating)
+			return;
 
 		const auto yawAngle = (cos(pTimer->GetTotal()) + 1.f) / 2.f * PI_2;
-		m_pBunnyMesh->RotateY(yawAngle);
-		m_pBunnyMesh->UpdateTransforms();
+		TriangleMesh& bunnyMesh{ m_TriangleMeshGeometries[m_BunnyMeshIndex] };
+		bunnyMesh.RotateY(yawAngle);
+		bunnyMesh.UpdateTransforms();
+	}
+#pragma endregion
+#pragma region SCENE_BUNNYGRID
+	void Scene_BunnyGrid::Initialize()
+	{
+		sceneName = "Bunny Grid Scene";
+		m_Camera.origin = { 0.f,8.f,-10.f };
+		m_Camera.totalPitch = -0.5f;
+		m_Camera.fovAngle = 45.f;
+
+		const auto matLambert_GrayBlue = AddMaterial(Material_Lambert{ { 0.49f, 0.57f, 0.57f }, 1.f });
+		const unsigned char materials[]
+		{
+			AddMaterial(Material_Lambert{ colors::White, 1.f }),
+			AddMaterial(Material_CookTorrence{ { 0.972f, 0.960f, 0.915f }, 1.f, 0.3f }),
+			AddMaterial(Material_CookTorrence{ { 0.75f, 0.75f, 0.75f }, 0.f, 0.6f })
+		};
+
+		//Ground
+		AddPlane(Vector3{ 0.f,0.f,0.f }, Vector3{ 0.f,1.f,0.f }, matLambert_GrayBlue);
+
+		//The bunny is loaded once, every grid cell is an instance sharing its triangles and BVH
+		const uint32_t sourceMeshIndex{ AddTriangleMesh(TriangleCullMode::BackFaceCulling, materials[0]) };
+		{
+			TriangleMesh& sourceMesh{ m_TriangleMeshGeometries[sourceMeshIndex] };
+			Utils::ParseOBJ("Resources/lowpoly_bunny.obj",
+				sourceMesh.pData->positions,
+				sourceMesh.pData->normals,
+				sourceMesh.pData->indices);
+			sourceMesh.UpdateAABB();
+		}
+
+		constexpr int columnCount{ 32 };
+		constexpr int rowCount{ 32 };
+		constexpr float spacing{ 1.5f };
+		m_TriangleMeshGeometries.reserve(static_cast<size_t>(columnCount) * rowCount);
+		for (int row{}; row < rowCount; ++row)
+		{
+			for (int column{}; column < columnCount; ++column)
+			{
+				//The source mesh is the first cell
+				const uint32_t meshIndex{ row == 0 && column == 0 ? sourceMeshIndex
+					: AddTriangleMeshInstance(sourceMeshIndex, materials[(row + column) % std::size(materials)]) };
+
+				TriangleMesh& mesh{ m_TriangleMeshGeometries[meshIndex] };
+				const float x{ (static_cast<float>(column) - (columnCount - 1) / 2.f) * spacing };
+				const float z{ static_cast<float>(row) * spacing };
+				mesh.Scale({ 0.5f,0.5f,0.5f });
+				mesh.RotateY(PI + static_cast<float>(row * columnCount + column) * 0.7f);
+				mesh.Translate({ x, 0.f, z });
+				mesh.UpdateTransforms();
+			}
+		}
+
+		//Lights
+		AddPointLight(Vector3{ 0.f, 10.f, 40.f }, 800.f, ColorRGB{ 1.f, 0.61f, 0.45f }); // Backlight
+		AddPointLight(Vector3{ -10.f, 10.f, -5.f }, 600.f, ColorRGB{ 1.f, 0.8f, 0.45f }); // Frontlight
+		AddDirectionalLight(Vector3{ 0.5f, -1.f, 0.5f }.Normalized(), 2.f, ColorRGB{ 0.34f, 0.47f, 0.68f });
+	}
+
+	void Scene_BunnyGrid::Update(Timer* pTimer)
+	{
+		Scene::Update(pTimer);
+		if (!m_IsAnimating)
+			return;
+
+		//Only the instance transforms change, the shared geometry and its BVH stay untouched
+		const float time{ pTimer->GetTotal() };
+		for (size_t meshIndex{}; meshIndex < m_TriangleMeshGeometries.size(); ++meshIndex)
+		{
+			TriangleMesh& mesh{ m_TriangleMeshGeometries[meshIndex] };
+			mesh.RotateY(PI + static_cast<float>(meshIndex) * 0.7f + time);
+			mesh.UpdateTransforms();
+		}
+	}
+#pragma endregion
+#pragma region SCENE_SPHEREFIELD
+	void Scene_SphereField::Initialize()
+	{
+		sceneName = "Sphere Field Scene";
+		m_Camera.origin = { 0.f,3.f,-9.f };
+		m_Camera.fovAngle = 45.f;
+
+		const unsigned char materials[]
+		{
+			AddMaterial(Material_CookTorrence{ { 0.972f, 0.960f, 0.915f }, 1.f, 0.3f }),
+			AddMaterial(Material_CookTorrence{ { 0.75f, 0.75f, 0.75f }, 0.f, 0.6f }),
+			AddMaterial(Material_Lambert{ { 0.49f, 0.57f, 0.57f }, 1.f }),
+			AddMaterial(Material_Lambert{ colors::White, 1.f })
+		};
+		const auto matLambert_GrayBlue = materials[2];
+
+		//Ground
+		AddPlane(Vector3{ 0.f,0.f,0.f }, Vector3{ 0.f,1.f,0.f }, matLambert_GrayBlue);
+
+		//Grid of small spheres on a wave
+		constexpr int columnCount{ 200 };
+		constexpr int rowCount{ 100 };
+		constexpr float spacing{ 0.25f };
+		constexpr float radius{ 0.1f };
+		m_SphereGeometries.reserve(static_cast<size_t>(columnCount) * rowCount);
+		for (int row{}; row < rowCount; ++row)
+		{
+			for (int column{}; column < columnCount; ++column)
+			{
+				const float x{ (static_cast<float>(column) - columnCount / 2.f) * spacing };
+				const float z{ static_cast<float>(row) * spacing };
+				const float y{ radius + 0.5f * (sinf(x) * cosf(z) + 1.f) };
+				AddSphere(Vector3{ x, y, z }, radius, materials[(row + column) % std::size(materials)]);
+			}
+		}
+
+		//Lights
+		AddPointLight(Vector3{ 0.f, 5.f, 5.f }, 50.f, ColorRGB{ 1.f, 0.61f, 0.45f }); // Backlight
+		AddPointLight(Vector3{ -2.5f, 5.f, -5.f }, 70.f, ColorRGB{ 1.f, 0.8f, 0.45f }); // Frontlight
+		AddPointLight(Vector3{ 2.5f, 2.5f, -5.f }, 50.f, ColorRGB{ 0.34f, 0.47f, 0.68f });
 	}
 #pragma endregion
 }
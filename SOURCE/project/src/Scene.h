@@ -1,18 +1,58 @@
 #pragma once
+#include <span>
 #include <string>
 #include <vector>
 #include "Math.h"
 #include "DataTypes.h"
 #include "Camera.h"
+#include "Kernels.h"
+#include "Material.h"
 
 namespace dae
 {
 	//Forward Declarations
 	class Timer;
-	class Material;
 	struct Plane;
 	struct Sphere;
 	struct Light;
+	class Scene;
+
+	//Immutable view of a scene for one frame, built once by Scene::UpdateAccelerationStructure
+	//Everything the renderer reads per pixel goes through this, no containers are copied
+	struct SceneRenderView final
+	{
+		std::span<const Material> materials{};
+		std::span<const Light> lights{};
+		std::span<const Plane> planes{};
+		std::span<const Sphere> spheres{};
+		std::span<const TriangleMesh> triangleMeshes{};
+
+		//Acceleration structures, see Scene
+		std::span<const PlaneBlock> planeBlocks{};
+		const BVH* pSphereBVH{};
+		std::span<const SphereBlock> sphereBlocks{};
+		std::span<const uint32_t> sphereLeafFirstBlock{};
+		const BVH* pMeshBVH{};
+
+		//Instruction set level the queries run with, set by the renderer
+		const Kernels* pKernels{};
+
+		void GetClosestHit(const Ray& ray, HitRecord& closestHit) const { pKernels->pGetClosestHit(*this, ray, closestHit); }
+		//Closest hits of all rays of a packet, pClosestHits needs one HitRecord per ray
+		void GetClosestHits(const RayPacket& packet, HitRecord* pClosestHits) const { pKernels->pGetClosestHits(*this, packet, pClosestHits); }
+		bool IsOccluded(const Ray& ray) const { return pKernels->pIsOccluded(*this, ray); }
+	};
+
+	//What changed since the previous Scene::UpdateAccelerationStructure, lets the renderer skip work
+	struct SceneChanges final
+	{
+		//The camera, lights, planes or spheres changed (or objects were added), every pixel can be affected
+		bool isFullyDirty{ true };
+		//Old and new world bounds of every mesh that moved
+		std::vector<AABB> dirtyMeshBounds{};
+
+		bool HasChanges() const { return isFullyDirty || !dirtyMeshBounds.empty(); }
+	};
 
 	//Scene Base Class
 	class Scene
@@ -29,17 +69,29 @@ namespace dae
 		virtual void Initialize() = 0;
 		virtual void Update(dae::Timer* pTimer)
 		{
-			m_Camera.Update(pTimer);
+			m_HasCameraMoved |= m_Camera.Update(pTimer);
 		}
+		//A paused scene only changes when the camera moves
+		void ToggleAnimation();
 
 		Camera& GetCamera() { return m_Camera; }
-		void GetClosestHit(const Ray& ray, HitRecord& closestHit) const;
-		bool DoesHit(const Ray& ray) const;
+		//Moves the camera from code (benchmark playback), a different pose redraws the frame like user input does
+		void SetCameraPose(const Vector3& origin, float pitch, float yaw)
+		{
+			m_HasCameraMoved |= !(origin == m_Camera.origin) || pitch != m_Camera.totalPitch || yaw != m_Camera.totalYaw;
+			m_Camera.origin = origin;
+			m_Camera.totalPitch = pitch;
+			m_Camera.totalYaw = yaw;
+		}
+		//Call once per frame before rendering, also refreshes the render view and the changes
+		void UpdateAccelerationStructure();
+		const SceneRenderView& GetRenderView() const { return m_RenderView; }
+		const SceneChanges& GetChanges() const { return m_Changes; }
 
 		const std::vector<Plane>& GetPlaneGeometries() const { return m_PlaneGeometries; }
 		const std::vector<Sphere>& GetSphereGeometries() const { return m_SphereGeometries; }
 		const std::vector<Light>& GetLights() const { return m_Lights; }
-		const std::vector<Material*> GetMaterials() const { return m_Materials; }
+		const std::vector<Material>& GetMaterials() const { return m_Materials; }
 
 	protected:
 		std::string	sceneName;
@@ -48,17 +100,41 @@ namespace dae
 		std::vector<Sphere> m_SphereGeometries{};
 		std::vector<TriangleMesh> m_TriangleMeshGeometries{};
 		std::vector<Light> m_Lights{};
-		std::vector<Material*> m_Materials{};
+		std::vector<Material> m_Materials{};
 
 		Camera m_Camera{};
+		bool m_IsAnimating{ true };
+
+		//Spheres and planes are also stored as SoA blocks, so a ray is tested against several of them at once
+		//Spheres are grouped per leaf of their own BVH, planes are infinite and always all tested
+		BVH m_SphereBVH{};
+		std::vector<AABB> m_SphereBounds{};
+		std::vector<SphereBlock> m_SphereBlocks{};
+		std::vector<uint32_t> m_SphereLeafFirstBlock{};
+		std::vector<PlaneBlock> m_PlaneBlocks{};
+
+		//Top level BVH over the meshes
+		BVH m_MeshBVH{};
+		std::vector<AABB> m_MeshBounds{};
+
+		SceneRenderView m_RenderView{};
+
+		//Change tracking, state of the previous UpdateAccelerationStructure
+		SceneChanges m_Changes{};
+		bool m_HasCameraMoved{ true };
+		std::vector<Light> m_PreviousLights{};
+		std::vector<Plane> m_PreviousPlanes{};
+		std::vector<uint32_t> m_MeshTransformVersions{};
 
 		Sphere* AddSphere(const Vector3& origin, float radius, unsigned char materialIndex = 0);
 		Plane* AddPlane(const Vector3& origin, const Vector3& normal, unsigned char materialIndex = 0);
-		TriangleMesh* AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex = 0);
+		//Meshes are returned by index, adding a mesh can move the others
+		uint32_t AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex = 0);
+		uint32_t AddTriangleMeshInstance(uint32_t sourceMeshIndex, unsigned char materialIndex = 0);
 
 		Light* AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color);
 		Light* AddDirectionalLight(const Vector3& direction, float intensity, const ColorRGB& color);
-		unsigned char AddMaterial(Material* pMaterial);
+		unsigned char AddMaterial(const Material& material);
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -78,7 +154,7 @@ namespace dae
 		void Update(Timer* pTimer) override;
 
 	private:
-		TriangleMesh* m_Meshes[3]{};
+		uint32_t m_MeshIndices[3]{};
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -98,7 +174,40 @@ namespace dae
 		void Update(Timer* pTimer) override;
 
 	private:
-		TriangleMesh* m_pBunnyMesh{nullptr};
+		uint32_t m_BunnyMeshIndex{};
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//Bunny Grid Scene (one bunny mesh, drawn many times through instances)
+	class Scene_BunnyGrid final : public Scene
+	{
+	public:
+		Scene_BunnyGrid() = default;
+		~Scene_BunnyGrid() override = default;
+
+		Scene_BunnyGrid(const Scene_BunnyGrid&) = delete;
+		Scene_BunnyGrid(Scene_BunnyGrid&&) noexcept = delete;
+		Scene_BunnyGrid& operator=(const Scene_BunnyGrid&) = delete;
+		Scene_BunnyGrid& operator=(Scene_BunnyGrid&&) noexcept = delete;
+
+		void Initialize() override;
+		void Update(Timer* pTimer) override;
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//Sphere Field Scene (procedural, lots of small spheres)
+	class Scene_SphereField final : public Scene
+	{
+	public:
+		Scene_SphereField() = default;
+		~Scene_SphereField() override = default;
+
+		Scene_SphereField(const Scene_SphereField&) = delete;
+		Scene_SphereField(Scene_SphereField&&) noexcept = delete;
+		Scene_SphereField& operator=(const Scene_SphereField&) = delete;
+		Scene_SphereField& operator=(Scene_SphereField&&) noexcept = delete;
+
+		void Initialize() override;
 	};
 	
 }
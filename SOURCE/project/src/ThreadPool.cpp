@@ -0,0 +1,147 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace dae
+{
+	namespace
+	{
+		uint64_t PackRange(uint32_t begin, uint32_t end)
+		{
+			return static_cast<uint64_t>(begin) | (static_cast<uint64_t>(end) << 32);
+		}
+	}
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+		m_Queues = std::vector<TaskQueue>(threadCount);
+
+		//Queue 0 belongs to the dispatching thread
+		m_Workers.reserve(threadCount - 1);
+		for (uint32_t queueIndex{ 1 }; queueIndex < threadCount; ++queueIndex)
+		{
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, queueIndex);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		m_IsStopping.store(true, std::memory_order_relaxed);
+		m_Generation.fetch_add(1, std::memory_order_release);
+		m_Generation.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::Dispatch(uint32_t taskCount, TaskFunction pTaskFunction, const void* pTask)
+	{
+		if (taskCount == 0)
+			return;
+
+		m_pTaskFunction = pTaskFunction;
+		m_pTask = pTask;
+
+		//Contiguous ranges keep neighbouring tasks (tiles) on the same thread
+		const uint32_t queueCount{ GetThreadCount() };
+		for (uint32_t queueIndex{}; queueIndex < queueCount; ++queueIndex)
+		{
+			const uint32_t begin{ static_cast<uint32_t>(static_cast<uint64_t>(taskCount) * queueIndex / queueCount) };
+			const uint32_t end{ static_cast<uint32_t>(static_cast<uint64_t>(taskCount) * (queueIndex + 1) / queueCount) };
+			m_Queues[queueIndex].range.store(PackRange(begin, end), std::memory_order_relaxed);
+		}
+
+		//Wake up the workers, the release publishes the task and the queues
+		m_BusyWorkers.store(static_cast<uint32_t>(m_Workers.size()), std::memory_order_relaxed);
+		m_Generation.fetch_add(1, std::memory_order_release);
+		m_Generation.notify_all();
+
+		RunTasks(0);
+
+		//The task has to outlive every worker that could still be touching it
+		uint32_t busyWorkers{ m_BusyWorkers.load(std::memory_order_acquire) };
+		while (busyWorkers > 0)
+		{
+			m_BusyWorkers.wait(busyWorkers, std::memory_order_acquire);
+			busyWorkers = m_BusyWorkers.load(std::memory_order_acquire);
+		}
+	}
+
+	void ThreadPool::WorkerLoop(uint32_t queueIndex)
+	{
+		uint32_t seenGeneration{ 0 };
+		while (true)
+		{
+			m_Generation.wait(seenGeneration, std::memory_order_acquire);
+			const uint32_t generation{ m_Generation.load(std::memory_order_acquire) };
+			if (generation == seenGeneration)
+				continue; //Spurious wake up
+
+			seenGeneration = generation;
+			if (m_IsStopping.load(std::memory_order_relaxed))
+				return;
+
+			RunTasks(queueIndex);
+
+			if (m_BusyWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				m_BusyWorkers.notify_all();
+		}
+	}
+
+	void ThreadPool::RunTasks(uint32_t queueIndex)
+	{
+		uint32_t taskIndex{};
+		while (PopTask(queueIndex, taskIndex) || StealTask(queueIndex, taskIndex))
+		{
+			m_pTaskFunction(m_pTask, taskIndex);
+		}
+	}
+
+	bool ThreadPool::PopTask(uint32_t queueIndex, uint32_t& taskIndex)
+	{
+		std::atomic<uint64_t>& range{ m_Queues[queueIndex].range };
+		uint64_t current{ range.load(std::memory_order_relaxed) };
+		while (true)
+		{
+			const uint32_t begin{ static_cast<uint32_t>(current) };
+			const uint32_t end{ static_cast<uint32_t>(current >> 32) };
+			if (begin >= end)
+				return false;
+
+			if (range.compare_exchange_weak(current, PackRange(begin + 1, end), std::memory_order_relaxed))
+			{
+				taskIndex = begin;
+				return true;
+			}
+		}
+	}
+
+	bool ThreadPool::StealTask(uint32_t queueIndex, uint32_t& taskIndex)
+	{
+		const uint32_t queueCount{ GetThreadCount() };
+		for (uint32_t offset{ 1 }; offset < queueCount; ++offset)
+		{
+			std::atomic<uint64_t>& range{ m_Queues[(queueIndex + offset) % queueCount].range };
+			uint64_t current{ range.load(std::memory_order_relaxed) };
+			while (true)
+			{
+				const uint32_t begin{ static_cast<uint32_t>(current) };
+				const uint32_t end{ static_cast<uint32_t>(current >> 32) };
+				if (begin >= end)
+					break;
+
+				//Take from the back, the owner keeps working on the front of its range
+				if (range.compare_exchange_weak(current, PackRange(begin, end - 1), std::memory_order_relaxed))
+				{
+					taskIndex = end - 1;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+}
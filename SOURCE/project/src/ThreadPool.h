@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	//Persistent pool of worker threads that run index based tasks (e.g. screen tiles)
+	//Every thread gets a contiguous range of tasks, threads that run out steal from the back of other ranges
+	//Nothing is allocated per dispatch, the threads and queues live as long as the pool
+	class ThreadPool final
+	{
+	public:
+		//threadCount includes the thread that dispatches, 0 = one thread per hardware thread
+		explicit ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Queues.size()); }
+
+		//Calls task(taskIndex) for every index in [0, taskCount) and returns once all of them are done
+		//The calling thread works along, task is only referenced (not copied) so capturing by reference is fine
+		template<typename Task>
+		void ParallelFor(uint32_t taskCount, const Task& task)
+		{
+			Dispatch(taskCount, [](const void* pTask, uint32_t taskIndex)
+				{
+					(*static_cast<const Task*>(pTask))(taskIndex);
+				}, &task);
+		}
+
+	private:
+		using TaskFunction = void(*)(const void* pTask, uint32_t taskIndex);
+
+		//Remaining tasks of one thread: first task in the low 32 bits, end in the high 32 bits
+		//Packed so the owner (front) and thieves (back) can both claim a task with a single compare exchange
+		//Aligned to a cache line so threads don't invalidate each other's queue
+		struct alignas(64) TaskQueue final
+		{
+			std::atomic<uint64_t> range{};
+		};
+
+		std::vector<TaskQueue> m_Queues{};
+		std::vector<std::thread> m_Workers{};
+
+		TaskFunction m_pTaskFunction{};
+		const void* m_pTask{};
+
+		std::atomic<uint32_t> m_Generation{};
+		std::atomic<uint32_t> m_BusyWorkers{};
+		std::atomic<bool> m_IsStopping{};
+
+		void Dispatch(uint32_t taskCount, TaskFunction pTaskFunction, const void* pTask);
+		void WorkerLoop(uint32_t queueIndex);
+		void RunTasks(uint32_t queueIndex);
+
+		bool PopTask(uint32_t queueIndex, uint32_t& taskIndex);
+		bool StealTask(uint32_t queueIndex, uint32_t& taskIndex);
+	};
+}
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <numeric>
 #include <fstream>
+#include <cfloat>
 #include "SDL.h"
 using namespace dae;
 
@@ -127,6 +128,12 @@ void Timer::Update()
 	}
 }
 
+void Timer::Step(float elapsedTime)
+{
+	m_ElapsedTime = elapsedTime;
+	m_TotalTime += elapsedTime;
+}
+
 void Timer::Stop()
 {
 	if (!m_IsStopped)
@@ -21,6 +21,8 @@ namespace dae
 		void Start();
 		void Update();
 		void Stop();
+		//Advances the timer by a fixed amount instead of the measured time, benchmarks play back deterministically this way
+		void Step(float elapsedTime);
 
 		uint32_t GetFPS() const { return m_FPS; };
 		float GetdFPS() const { return m_dFPS; };
@@ -5,6 +5,8 @@
 
 namespace dae
 {
+	//Scalar hit tests of single primitives, the renderer uses the block kernels (Kernels.inl) instead
+	//Kept for reference and for the kernel benchmark, compiled for the baseline instruction set only
 	namespace GeometryUtils
 	{
 #pragma region Sphere HitTest
@@ -21,8 +23,13 @@ namespace dae
 			//Calculate distance of tAdjacent and origin of sphere
 			const float oppositeSideSqrd{ rayToSphereOrigin.SqrMagnitude() - Square(tAdjacent) };
 
+			//Ray passes next to the sphere, no need for the square root
+			const float tDeltaSqrd{ Square(sphere.radius) - oppositeSideSqrd };
+			if (tDeltaSqrd < 0.f)
+				return false;
+
 			//Calculate difference (in t) between tAdjacent and border of sphere
-			const float tDelta{ sqrt(Square(sphere.radius) - oppositeSideSqrd) };
+			const float tDelta{ sqrtf(tDeltaSqrd) };
 
 			//t value of intersection between ray and sphere
 			const float t0{ tAdjacent - tDelta };
@@ -62,10 +69,22 @@ namespace dae
 			return false;
 		}
 
+		//Occlusion test, only checks if the sphere is hit between ray.min and ray.max (no hit information)
 		inline bool HitTest_Sphere(const Sphere& sphere, const Ray& ray)
 		{
-			HitRecord temp{};
-			return HitTest_Sphere(sphere, ray, temp, true);
+			const Vector3 rayToSphereOrigin{ sphere.origin - ray.origin };
+			const float tAdjacent{ Vector3::Dot(rayToSphereOrigin, ray.direction) };
+			const float tDeltaSqrd{ Square(sphere.radius) - (rayToSphereOrigin.SqrMagnitude() - Square(tAdjacent)) };
+
+			//Ray passes next to the sphere
+			if (tDeltaSqrd < 0.f)
+				return false;
+
+			const float tDelta{ sqrtf(tDeltaSqrd) };
+			const float t0{ tAdjacent - tDelta };
+			const float t1{ tAdjacent + tDelta };
+
+			return (t0 > ray.min && t0 < ray.max) || (t1 > ray.min && t1 < ray.max);
 		}
 #pragma endregion
 #pragma region Plane HitTest
@@ -94,14 +113,48 @@ namespace dae
 			return false;
 		}
 
+		//Occlusion test, only checks if the plane is hit between ray.min and ray.max (no hit information)
 		inline bool HitTest_Plane(const Plane& plane, const Ray& ray)
 		{
-			HitRecord temp{};
-			return HitTest_Plane(plane, ray, temp, true);
+			const float t{ Vector3::Dot(plane.origin - ray.origin, plane.normal) / Vector3::Dot(ray.direction, plane.normal) };
+			return t > ray.min && t < ray.max;
 		}
 #pragma endregion
 #pragma region Triangle HitTest
 		//TRIANGLE HIT-TESTS
+
+		//Is point (on the plane of the triangle) to the 'right side' of each edge
+		inline bool IsPointInTriangle(const Triangle& triangle, const Vector3& intersectionPoint)
+		{
+			Vector3 edge{}, pointToVertex{}, cross{};
+
+			//Edge v0 -> v1
+			edge = triangle.v1 - triangle.v0;
+			pointToVertex = intersectionPoint - triangle.v0;
+			cross = Vector3::Cross(edge, pointToVertex); //no need to normalize, we only check if < 0
+			if (Vector3::Dot(cross, triangle.normal) < 0.f)
+				//Point is on the left side of edge -> outside triangle
+				return false;
+
+			//Edge v1 -> v2
+			edge = triangle.v2 - triangle.v1;
+			pointToVertex = intersectionPoint - triangle.v1;
+			cross = Vector3::Cross(edge, pointToVertex); //no need to normalize, we only check if < 0
+			if (Vector3::Dot(cross, triangle.normal) < 0.f)
+				//Point is on the left side of edge -> outside triangle
+				return false;
+
+			//Edge v2 -> v0
+			edge = triangle.v0 - triangle.v2;
+			pointToVertex = intersectionPoint - triangle.v2;
+			cross = Vector3::Cross(edge, pointToVertex); //no need to normalize, we only check if < 0
+			if (Vector3::Dot(cross, triangle.normal) < 0.f)
+				//Point is on the left side of edge -> outside triangle
+				return false;
+
+			return true;
+		}
+
 		inline bool HitTest_Triangle(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
 		{
 			//Use temporary hitRecord so we don't override previous data if no hit occurs
@@ -143,35 +196,9 @@ namespace dae
 
 
 			//INSIDE OUTSIDE TEST
-			//Is intersection point to the 'right side' of each edge
-			Vector3 edge{}, pointToVertex{}, cross{};
-			const Vector3 intersectionPoint{ temp.origin }; //intersection with plane
-
-			//Edge v0 -> v1
-			edge = triangle.v1 - triangle.v0;
-			pointToVertex = intersectionPoint - triangle.v0;
-			cross = Vector3::Cross(edge, pointToVertex); //no need to normalize, we only check if < 0
-			if (Vector3::Dot(cross, triangle.normal) < 0.f)
-				//Point is on the left side of edge -> outside triangle
+			if (not IsPointInTriangle(triangle, temp.origin))
 				return false;
 
-			//Edge v1 -> v2
-			edge = triangle.v2 - triangle.v1;
-			pointToVertex = intersectionPoint - triangle.v1;
-			cross = Vector3::Cross(edge, pointToVertex); //no need to normalize, we only check if < 0
-			if (Vector3::Dot(cross, triangle.normal) < 0.f)
-				//Point is on the left side of edge -> outside triangle
-				return false;
-
-			//Edge v2 -> v0
-			edge = triangle.v0 - triangle.v2;
-			pointToVertex = intersectionPoint - triangle.v2;
-			cross = Vector3::Cross(edge, pointToVertex); //no need to normalize, we only check if < 0
-			if (Vector3::Dot(cross, triangle.normal) < 0.f)
-				//Point is on the left side of edge -> outside triangle
-				return false;
-			//INSIDE OUTSIDE TEST was successful
-
 
 			//Flip normal when hitting a back facing triangle, so lighting is correct
 			const bool isBackFace{ Vector3::Dot(temp.normal, ray.direction) > 0.f };
@@ -183,79 +210,37 @@ namespace dae
 			return true;
 		}
 
+		//Occlusion test, only checks if the triangle is hit between ray.min and ray.max (no hit information)
+		//Used for shadow rays, so the culling mode is inverted
 		inline bool HitTest_Triangle(const Triangle& triangle, const Ray& ray)
 		{
-			HitRecord temp{};
-			return HitTest_Triangle(triangle, ray, temp, true);
-		}
-#pragma endregion
-#pragma region TriangleMesh SlabTest
-		//Slab test to check if ray intersects with bounding box of mesh
-		inline bool SlabTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray)
-		{
-			const float tx1 = (mesh.transformedMinAABB.x - ray.origin.x) / ray.direction.x;
-			const float tx2 = (mesh.transformedMaxAABB.x - ray.origin.x) / ray.direction.x;
-
-			float tmin = std::min(tx1, tx2);
-			float tmax = std::max(tx1, tx2);
-
-			const float ty1 = (mesh.transformedMinAABB.y - ray.origin.y) / ray.direction.y;
-			const float ty2 = (mesh.transformedMaxAABB.y - ray.origin.y) / ray.direction.y;
-
-			tmin = std::max(tmin, std::min(ty1, ty2));
-			tmax = std::min(tmax, std::max(ty1, ty2));
-
-			const float tz1 = (mesh.transformedMinAABB.z - ray.origin.z) / ray.direction.z;
-			const float tz2 = (mesh.transformedMaxAABB.z - ray.origin.z) / ray.direction.z;
-
-			tmin = std::max(tmin, std::min(tz1, tz2));
-			tmax = std::min(tmax, std::max(tz1, tz2));
-
-			return tmax > 0 && tmax >= tmin;
-		}
-#pragma endregion
-#pragma region TriangeMesh HitTest
-		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
-		{
-			//slabTest
-			if (!SlabTest_TriangleMesh(mesh, ray)) return false;
+			const float normalDotDirection{ Vector3::Dot(triangle.normal, ray.direction) };
 
-			//Use temporary hitRecord to avoid false positive from previous hitTest
-			HitRecord temp{};
+			//Check if ray is parallel to triangle
+			if (AreEqual(normalDotDirection, 0.f))
+				return false;
 
-			for (size_t normalIndex{}; normalIndex < mesh.transformedNormals.size(); ++normalIndex)
+			//Inverted Cull Mode Check
+			switch (triangle.cullMode)
 			{
-				const size_t tripletIndex{ normalIndex * 3 }; //3 indices for every normal/triangle
-				const Vector3& v0{ mesh.transformedPositions[mesh.indices[tripletIndex]] },
-					& v1{ mesh.transformedPositions[mesh.indices[tripletIndex + 1]] },
-					& v2{ mesh.transformedPositions[mesh.indices[tripletIndex + 2]] };
-
-				Triangle triangle{ v0,v1,v2, mesh.transformedNormals[normalIndex] };
-				triangle.cullMode = mesh.cullMode;
-				//Material index does not need to be set, will be done at the end if a hit is found
-				HitTest_Triangle(triangle, ray, temp, ignoreHitRecord);
+			case TriangleCullMode::FrontFaceCulling:
+				if (normalDotDirection > 0.f) return false;
+				break;
+			case TriangleCullMode::BackFaceCulling:
+				if (normalDotDirection < 0.f) return false;
+				break;
+			case TriangleCullMode::NoCulling:
+				break;
 			}
 
-			if (temp.didHit && temp.t < hitRecord.t)
-			{
-				if (not ignoreHitRecord)
-				{
-					hitRecord = temp;
-					hitRecord.materialIndex = mesh.materialIndex;
-					//Update material if mesh is the closest hit, instead of setting for every triangle
-				}
-				return true;
-			}
-			return false;
-		}
+			//Check if ray hits plane of triangle within range
+			const float t{ Vector3::Dot(triangle.v0 - ray.origin, triangle.normal) / normalDotDirection };
+			if (t <= ray.min || t >= ray.max)
+				return false;
 
-		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray)
-		{
-			HitRecord temp{};
-			return HitTest_TriangleMesh(mesh, ray, temp, true);
+			return IsPointInTriangle(triangle, ray.origin + ray.direction * t);
 		}
 #pragma endregion
-
 	}
 
 	namespace LightUtils
@@ -3,11 +3,10 @@
 #include <cmath>
 
 namespace dae {
-	const Vector2 Vector2::UnitX = Vector2{ 1, 0 };
-	const Vector2 Vector2::UnitY = Vector2{ 0, 1 };
-	const Vector2 Vector2::Zero = Vector2{ 0, 0 };
-
-	Vector2::Vector2(float _x, float _y) : x(_x), y(_y) {}
+	//Constant initialized, a dynamic initializer would run at startup before the CPU features are checked
+	constinit const Vector2 Vector2::UnitX = Vector2{ 1, 0 };
+	constinit const Vector2 Vector2::UnitY = Vector2{ 0, 1 };
+	constinit const Vector2 Vector2::Zero = Vector2{ 0, 0 };
 
 	Vector2::Vector2(const Vector2& from, const Vector2& to) : x(to.x - from.x), y(to.y - from.y) {}
 
@@ -8,7 +8,7 @@ namespace dae
 		float y{};
 
 		Vector2() = default;
-		Vector2(float _x, float _y);
+		constexpr Vector2(float _x, float _y) : x(_x), y(_y) {}
 		Vector2(const Vector2& from, const Vector2& to);
 
 		float Magnitude() const;
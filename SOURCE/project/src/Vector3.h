@@ -1,4 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "MathHelpers.h"
 
 namespace dae
 {
@@ -11,7 +15,7 @@ namespace dae
 		float z{};
 
 		Vector3() = default;
-		Vector3(float _x, float _y, float _z);
+		constexpr Vector3(float _x, float _y, float _z);
 		Vector3(const Vector3& from, const Vector3& to);
 		Vector3(const Vector4& v);
 
@@ -58,4 +62,164 @@ namespace dae
 	{
 		return { v.x * scale, v.y * scale, v.z * scale };
 	}
+
+	//Everything that doesn't need Vector2/Vector4 is defined here, so intersection tests and BRDFs can inline it
+	constexpr Vector3::Vector3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+
+	inline Vector3::Vector3(const Vector3& from, const Vector3& to) : x(to.x - from.x), y(to.y - from.y), z(to.z - from.z) {}
+
+	inline float Vector3::Magnitude() const
+	{
+		return std::sqrt(x * x + y * y + z * z);
+	}
+
+	inline float Vector3::SqrMagnitude() const
+	{
+		return x * x + y * y + z * z;
+	}
+
+	inline float Vector3::Normalize()
+	{
+		const float m = Magnitude();
+		x /= m;
+		y /= m;
+		z /= m;
+
+		return m;
+	}
+
+	inline Vector3 Vector3::Normalized() const
+	{
+		const float m = Magnitude();
+		return { x / m, y / m, z / m };
+	}
+
+	inline float Vector3::Dot(const Vector3& v1, const Vector3& v2)
+	{
+		return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+	}
+
+	inline Vector3 Vector3::Cross(const Vector3& v1, const Vector3& v2)
+	{
+		return Vector3{
+			v1.y * v2.z - v1.z * v2.y,
+			v1.z * v2.x - v1.x * v2.z,
+			v1.x * v2.y - v1.y * v2.x
+		};
+	}
+
+	inline Vector3 Vector3::Project(const Vector3& v1, const Vector3& v2)
+	{
+		return (v2 * (Dot(v1, v2) / Dot(v2, v2)));
+	}
+
+	inline Vector3 Vector3::Reject(const Vector3& v1, const Vector3& v2)
+	{
+		return (v1 - v2 * (Dot(v1, v2) / Dot(v2, v2)));
+	}
+
+	inline Vector3 Vector3::Reflect(const Vector3& v1, const Vector3& v2)
+	{
+		return v1 - (2.f * Vector3::Dot(v1, v2) * v2);
+	}
+
+	inline Vector3 Vector3::Max(const Vector3& v1, const Vector3& v2)
+	{
+		return{
+			std::max(v1.x, v2.x),
+			std::max(v1.y,v2.y),
+			std::max(v1.z, v2.z)
+		};
+	}
+
+	inline Vector3 Vector3::Min(const Vector3& v1, const Vector3& v2)
+	{
+		return{
+			std::min(v1.x, v2.x),
+			std::min(v1.y,v2.y),
+			std::min(v1.z, v2.z)
+		};
+	}
+
+#pragma region Operator Overloads
+	inline Vector3 Vector3::operator*(float scale) const
+	{
+		return { x * scale, y * scale, z * scale };
+	}
+
+	inline Vector3 Vector3::operator/(float scale) const
+	{
+		return { x / scale, y / scale, z / scale };
+	}
+
+	inline Vector3 Vector3::operator+(const Vector3& v) const
+	{
+		return { x + v.x, y + v.y, z + v.z };
+	}
+
+	inline Vector3 Vector3::operator-(const Vector3& v) const
+	{
+		return { x - v.x, y - v.y, z - v.z };
+	}
+
+	inline Vector3 Vector3::operator-() const
+	{
+		return { -x ,-y,-z };
+	}
+
+	inline Vector3& Vector3::operator*=(float scale)
+	{
+		x *= scale;
+		y *= scale;
+		z *= scale;
+		return *this;
+	}
+
+	inline Vector3& Vector3::operator/=(float scale)
+	{
+		x /= scale;
+		y /= scale;
+		z /= scale;
+		return *this;
+	}
+
+	inline Vector3& Vector3::operator-=(const Vector3& v)
+	{
+		x -= v.x;
+		y -= v.y;
+		z -= v.z;
+		return *this;
+	}
+
+	inline Vector3& Vector3::operator+=(const Vector3& v)
+	{
+		x += v.x;
+		y += v.y;
+		z += v.z;
+		return *this;
+	}
+
+	inline float& Vector3::operator[](int index)
+	{
+		assert(index <= 2 && index >= 0);
+
+		if (index == 0) return x;
+		if (index == 1) return y;
+		return z;
+	}
+
+	inline float Vector3::operator[](int index) const
+	{
+		assert(index <= 2 && index >= 0);
+
+		if (index == 0) return x;
+		if (index == 1) return y;
+		return z;
+	}
+
+	inline bool Vector3::operator==(const Vector3& v) const
+	{
+		return AreEqual(x, v.x) && AreEqual(y, v.y) && AreEqual(z, v.z);
+	}
+#pragma endregion
 }
@@ -34,4 +34,6 @@ namespace dae
 		float operator[](int index) const;
 		bool operator==(const Vector4& v) const;
 	};
+
+	inline Vector4::Vector4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
 }
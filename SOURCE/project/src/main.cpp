@@ -4,120 +4,222 @@
 #undef main
 
 //Standard includes
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 //Project includes
-#include "Timer.h"
-#include "Renderer.h"
-#include "Scene.h"
+#include "Application.h"
+#include "CpuFeatures.h"
 #if defined(_DEBUG)
 #include "LeakDetector.h"
 #endif
 
 using namespace dae;
 
-void ShutDown(SDL_Window* pWindow)
+void PrintUsage()
 {
-	SDL_DestroyWindow(pWindow);
-	SDL_Quit();
+	std::cout << "Usage: GP1_Raytracer [options]\n"
+		<< "  --headless          render without a window and write the frames to disk\n"
+		<< "  --scene <name>      reference | bunny | bunnygrid | spherefield (default reference)\n"
+		<< "  --width <pixels>    default 640\n"
+		<< "  --height <pixels>   default 480\n"
+		<< "  --frames <count>    frames to render in headless mode (default 1) or benchmark mode (default: the whole camera path)\n"
+		<< "  --output <path>     headless output prefix, frames are written as <path>_0000.bmp (default frame)\n"
+		<< "  --raw               write raw 32 bit ARGB frames (<path>_0000.raw) instead of bmp\n"
+		<< "  --threads <count>   render threads, 0 = one per hardware thread (default 0)\n"
+		<< "  --tile-size <size>  size of the screen tiles handed to the threads\n"
+		<< "  --deferred          shade from a G-buffer with the pixels grouped per material\n"
+		<< "  --srgb              gamma correct the output\n"
+		<< "  --progressive       accumulate anti-aliased samples while the camera and scene are static\n"
+		<< "  --no-animation      start with the scene animation paused\n"
+		<< "  --aa                supersample the pixels on edges\n"
+		<< "  --aa-budget <rays>  extra rays per frame for --aa (default 65536)\n"
+		<< "  --dynamic-resolution  lower the render resolution while frames take longer than the target\n"
+		<< "  --target-frame-time <ms>  frame time dynamic resolution aims for (default 16.6)\n"
+		<< "  --min-scale <scale> lowest render scale per axis (default 0.5)\n"
+		<< "  --max-scale <scale> highest render scale per axis (default 1)\n"
+		<< "  --isa <level>       sse4 | avx2, force the kernels of a lower level (default: highest the cpu supports)\n"
+		<< "  --benchmark <path>  play a camera path with a fixed time step without a window, write the frame times as JSON to <path>\n"
+		<< "  --camera-path <path>  camera path for --benchmark (default: a fly through from the scene camera)\n"
+		<< "  --time-step <ms>    time between benchmark frames (default 16.67)\n"
+		<< "  --warmup <count>    frames rendered before the benchmark is measured (default 3)\n"
+		<< "  --record-camera-path <path>  save the path the camera flies in the window to <path> on exit\n";
 }
 
-int main(int argc, char* args[])
+bool ParseCommandLine(int argc, char* args[], CommandLineOptions& options)
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
-
-	// Leak detection
-	#if defined(_DEBUG)
-		LeakDetector detector{};
-	#endif
-
-	//Create window + surfaces
-	SDL_Init(SDL_INIT_VIDEO);
-
-	const uint32_t width = 640;
-	const uint32_t height = 480;
-
-	SDL_Window* pWindow = SDL_CreateWindow(
-		"RayTracer - Senne Goeminne (2DAE19)",
-		SDL_WINDOWPOS_UNDEFINED,
-		SDL_WINDOWPOS_UNDEFINED,
-		width, height, 0);
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const std::string argument{ args[i] };
 
-	if (!pWindow)
-		return 1;
+		//Flags
+		if (argument == "--help")
+			return false;
+		if (argument == "--headless")
+		{
+			options.headless = true;
+			continue;
+		}
+		if (argument == "--raw")
+		{
+			options.rawOutput = true;
+			continue;
+		}
+		if (argument == "--deferred")
+		{
+			options.deferredShading = true;
+			continue;
+		}
+		if (argument == "--srgb")
+		{
+			options.sRGB = true;
+			continue;
+		}
+		if (argument == "--progressive")
+		{
+			options.progressive = true;
+			continue;
+		}
+		if (argument == "--no-animation")
+		{
+			options.animation = false;
+			continue;
+		}
+		if (argument == "--aa")
+		{
+			options.adaptiveAA = true;
+			continue;
+		}
+		if (argument == "--dynamic-resolution")
+		{
+			options.dynamicResolution = true;
+			continue;
+		}
 
-	//Initialize "framework"
-	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+		//Options with a value
+		if (i + 1 >= argc)
+		{
+			std::cout << "Unknown option or missing value: " << argument << "\n";
+			return false;
+		}
+		const char* value{ args[++i] };
+
+		if (argument == "--scene")
+			options.sceneName = value;
+		else if (argument == "--output")
+			options.outputPath = value;
+		else if (argument == "--width")
+			options.width = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (argument == "--height")
+			options.height = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (argument == "--frames")
+			options.frameCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (argument == "--threads")
+			options.threadCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (argument == "--tile-size")
+			options.tileSize = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (argument == "--aa-budget")
+			options.antiAliasingRayBudget = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (argument == "--target-frame-time")
+			options.targetFrameTime = std::strtof(value, nullptr);
+		else if (argument == "--min-scale")
+			options.minScale = std::strtof(value, nullptr);
+		else if (argument == "--max-scale")
+			options.maxScale = std::strtof(value, nullptr);
+		else if (argument == "--isa")
+			options.isaLevel = value;
+		else if (argument == "--benchmark")
+			options.benchmarkPath = value;
+		else if (argument == "--camera-path")
+			options.cameraPathFile = value;
+		else if (argument == "--time-step")
+			options.timeStep = std::strtof(value, nullptr);
+		else if (argument == "--warmup")
+			options.warmupFrameCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if (argument == "--record-camera-path")
+			options.recordCameraPathFile = value;
+		else
+		{
+			std::cout << "Unknown option: " << argument << "\n";
+			return false;
+		}
+	}
 
-	const auto pScene = new Scene_Reference();
-	pScene->Initialize();
+	if (options.width == 0 || options.height == 0)
+	{
+		std::cout << "Width and height have to be at least 1\n";
+		return false;
+	}
+	if (options.targetFrameTime <= 0.f || options.minScale <= 0.f || options.maxScale > 1.f || options.minScale > options.maxScale)
+	{
+		std::cout << "The target frame time has to be positive and 0 < min scale <= max scale <= 1\n";
+		return false;
+	}
+	if (options.timeStep <= 0.f)
+	{
+		std::cout << "The time step has to be positive\n";
+		return false;
+	}
+	return true;
+}
 
-	//Start loop
-	pTimer->Start();
+//Highest level the cpu supports, unless the command line forces one
+bool SelectIsaLevel(const CommandLineOptions& options, IsaLevel& isaLevel)
+{
+	if (!IsCpuSupported())
+	{
+		std::cout << "This cpu is not supported, the renderer needs at least SSE4.2 and POPCNT\n";
+		return false;
+	}
 
-	// Start Benchmark
-	// pTimer->StartBenchmark();
+	const IsaLevel supportedLevel{ GetSupportedIsaLevel() };
+	isaLevel = supportedLevel;
+	if (options.isaLevel.empty())
+		return true;
 
-	float printTimer = 0.f;
-	bool isLooping = true;
-	bool takeScreenshot = false;
-	while (isLooping)
+	IsaLevel forcedLevel{};
+	if (!ParseIsaLevel(options.isaLevel.c_str(), forcedLevel))
 	{
-		//--------- Get input events ---------
-		SDL_Event e;
-		while (SDL_PollEvent(&e))
-		{
-			switch (e.type)
-			{
-			case SDL_QUIT:
-				isLooping = false;
-				break;
-			case SDL_KEYUP:
-				if (e.key.keysym.scancode == SDL_SCANCODE_X)
-					takeScreenshot = true;
-				if (e.key.keysym.scancode == SDL_SCANCODE_F2)
-					pRenderer->ToggleShadows();
-				if (e.key.keysym.scancode == SDL_SCANCODE_F3)
-					pRenderer->CycleLightingMode();
-				break;
-			}
-		}
-
-		//--------- Update ---------
-		pScene->Update(pTimer);
+		std::cout << "Unknown instruction set level: " << options.isaLevel << "\n";
+		return false;
+	}
+	if (forcedLevel > supportedLevel)
+	{
+		std::cout << GetIsaLevelName(forcedLevel) << " is not supported by this cpu, the highest level is " << GetIsaLevelName(supportedLevel) << "\n";
+		return false;
+	}
+	isaLevel = forcedLevel;
+	return true;
+}
 
-		//--------- Render ---------
-		pRenderer->Render(pScene);
+int Run(const CommandLineOptions& options, IsaLevel isaLevel)
+{
+	if (!options.benchmarkPath.empty())
+		return RunBenchmark(options, isaLevel);
+	return options.headless ? RunHeadless(options, isaLevel) : RunWindowed(options, isaLevel);
+}
 
-		//--------- Timer ---------
-		pTimer->Update();
-		printTimer += pTimer->GetElapsed();
-		if (printTimer >= 1.f)
-		{
-			printTimer = 0.f;
-			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
-		}
+int main(int argc, char* args[])
+{
+	// Leak detection
+	#if defined(_DEBUG)
+		LeakDetector detector{};
+	#endif
 
-		//Save screenshot after full render
-		if (takeScreenshot)
-		{
-			if (!pRenderer->SaveBufferToImage())
-				std::cout << "Screenshot saved!" << std::endl;
-			else
-				std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
-			takeScreenshot = false;
-		}
+	CommandLineOptions options{};
+	if (!ParseCommandLine(argc, args, options))
+	{
+		PrintUsage();
+		return 1;
 	}
-	pTimer->Stop();
 
-	//Shutdown "framework"
-	delete pScene;
-	delete pRenderer;
-	delete pTimer;
+	IsaLevel isaLevel{};
+	if (!SelectIsaLevel(options, isaLevel))
+		return 1;
+
+	const int result{ Run(options, isaLevel) };
 
-	ShutDown(pWindow);
-	return 0;
-}
\ No newline at end of file
+	SDL_Quit();
+	return result;
+}